@@ -41,6 +41,9 @@
 /**
  * @brief Endpoint of the MQTT broker to connect to in mqtt test.
  *
+ * @note The MQTT broker in tools/mqtt_broker can be used to run the test on a
+ * local network.
+ *
  * #define MQTT_SERVER_ENDPOINT   "PLACE_HOLDER"
  */
 
@@ -72,6 +75,308 @@
  * #define MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS  ( 700 )
  */
 
+/**
+ * @brief Speed up factor of the clock used by the MQTT test.
+ *
+ * When defined, the time function passed to MQTT_Init and the waits of the
+ * MQTT test cases run this many times faster than pGetTimeMs of
+ * MqttTestParam_t. Keep-alive, PINGRESP, CONNACK and process loop timeouts
+ * then expire sooner in real time, which shortens the MQTT test run. Only use
+ * it with a broker on the local network, such as the one in tools/mqtt_broker,
+ * as the network round trips must fit in the shortened timeouts. The MQTT
+ * benchmarks keep measuring real time, and the 30 second wait for the broker
+ * to drop the connection in MQTT_Restore_Session_Duplicate_Incoming_Publish_Qos1
+ * is not shortened.
+ *
+ * #define MQTT_TEST_TIME_WARP_FACTOR  ( 10U )
+ */
+
+/**
+ * @brief Share one established MQTT session between the MQTT tests which do
+ * not depend on the session state.
+ *
+ * When defined, consecutive tests that only need a clean session reuse the
+ * connection of the previous passing test instead of doing a new network
+ * connect and MQTT CONNECT. Tests such as LWT, keep-alive, retained message
+ * and persistent session tests still use a new session. The tests sharing the
+ * session run first, so the MQTT tests run in a different order than without
+ * this option. The setup time of each test is printed so the savings are
+ * visible.
+ *
+ * #define MQTT_TEST_REUSE_CONNECTION
+ */
+
+/**
+ * @brief Record the MQTT packets sent and received by the MQTT test sessions.
+ *
+ * When defined, the transport send, recv and writev functions are wrapped to
+ * log the type, length, packet identifier and timestamp of every packet in a
+ * RAM ring. The trace is printed after each test and can be converted to JSON
+ * or pcap with tools/mqtt_trace. Nothing is added when it is not defined.
+ *
+ * #define MQTT_TEST_PACKET_TRACE
+ */
+
+/**
+ * @brief Number of packets kept by the MQTT packet trace. The oldest packets
+ * are overwritten when more packets are exchanged in a test.
+ *
+ * #define MQTT_TEST_PACKET_TRACE_ENTRY_COUNT  ( 256U )
+ */
+
+/**
+ * @brief Timestamp in microseconds of the MQTT packet trace. The default has
+ * the resolution of FRTest_GetTimeMs(); define it to read a high resolution
+ * timer.
+ *
+ * #define MQTT_TEST_PACKET_TRACE_GET_TIME_US()  ( FRTest_GetTimeMs() * 1000U )
+ */
+
+/**
+ * @brief Define this macro to run the MQTT benchmark test group after the MQTT
+ * test. The benchmarks print their results with the Unity output. Running them
+ * against the MQTT broker in tools/mqtt_broker on the local network keeps the
+ * results free of cloud round trips.
+ *
+ * #define MQTT_TEST_EXECUTE_BENCHMARK_TESTS
+ */
+
+/**
+ * @brief Number of messages published for each QoS level and payload size by
+ * the MQTT publish throughput benchmark, for each payload size and send
+ * method by the MQTT writev versus send benchmark, and for each window by the
+ * MQTT QoS 2 handshake benchmark.
+ *
+ * #define MQTT_BENCHMARK_PUBLISH_COUNT  ( 100U )
+ */
+
+/**
+ * @brief Payload sizes in bytes used by the MQTT publish throughput, writev
+ * versus send and network buffer sizing benchmarks. The network buffer sizing
+ * benchmark reports the smallest network buffer that sends and receives back a
+ * message of each size.
+ * Every size must not exceed MQTT_TEST_NETWORK_BUFFER_SIZE.
+ *
+ * #define MQTT_BENCHMARK_PAYLOAD_SIZES  { 16U, 256U, 1024U }
+ */
+
+/**
+ * @brief Timestamp in microseconds used by the MQTT latency benchmarks and to
+ * measure the time spent publishing in the writev versus send benchmark.
+ *
+ * The default has the resolution of FRTest_GetTimeMs(). Define it to read a
+ * high resolution timer for sub-millisecond results, e.g. a cycle counter
+ * scaled to microseconds. The value may wrap around.
+ *
+ * #define MQTT_BENCHMARK_GET_TIME_US()  ( FRTest_GetTimeMs() * 1000U )
+ */
+
+/**
+ * @brief Number of messages published for each QoS level by the MQTT
+ * publish-to-receive latency benchmark.
+ *
+ * #define MQTT_BENCHMARK_LATENCY_SAMPLES  ( 100U )
+ */
+
+/**
+ * @brief Payload size in bytes of the MQTT latency benchmark messages. It must
+ * be at least 8 bytes to hold the sequence number and the timestamp.
+ *
+ * #define MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE  ( 16U )
+ */
+
+/**
+ * @brief Payload size in bytes of the MQTT windowed publish, session restore
+ * and QoS 2 handshake benchmark messages. The windowed publish and QoS 2
+ * handshake benchmarks keep up to OUTGOING_PUBLISH_RECORD_COUNT publishes in
+ * flight.
+ *
+ * #define MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE  ( 256U )
+ */
+
+/**
+ * @brief Number of unacknowledged QoS 1 publishes resent by the MQTT session
+ * restore benchmark. It must not exceed OUTGOING_PUBLISH_RECORD_COUNT.
+ *
+ * #define MQTT_BENCHMARK_PENDING_PUBLISH_COUNT  OUTGOING_PUBLISH_RECORD_COUNT
+ */
+
+/**
+ * @brief Number of topic filters subscribed to by the MQTT subscription table
+ * benchmark. It must be at least 40.
+ *
+ * AWS IoT Core limits the subscriptions per connection, so run this benchmark
+ * against a broker without that limit, such as the one in tools/mqtt_broker.
+ *
+ * #define MQTT_BENCHMARK_TOPIC_FILTER_COUNT  ( 200U )
+ */
+
+/**
+ * @brief Maximum number of topic filters in a SUBSCRIBE packet of the MQTT
+ * subscription table benchmark. The packets are also limited to
+ * MQTT_TEST_NETWORK_BUFFER_SIZE bytes. AWS IoT Core accepts up to 8 topic
+ * filters per SUBSCRIBE packet.
+ *
+ * #define MQTT_BENCHMARK_MAX_FILTERS_PER_SUBSCRIBE  MQTT_BENCHMARK_TOPIC_FILTER_COUNT
+ */
+
+/**
+ * @brief Number of concurrent MQTT clients in the concurrent clients
+ * benchmark. It must be at least 2.
+ *
+ * The clients use pNetworkContext, pSecondNetworkContext and then the
+ * pBenchmarkNetworkContexts of MqttTestParam_t, so benchmarkNetworkContextCount
+ * must be at least MQTT_BENCHMARK_CLIENT_COUNT - 2. Each client other than the
+ * first one has its own MQTT_TEST_NETWORK_BUFFER_SIZE network buffer.
+ *
+ * #define MQTT_BENCHMARK_CLIENT_COUNT  ( 2U )
+ */
+
+/**
+ * @brief Payload size in bytes of the MQTT concurrent clients benchmark
+ * messages.
+ *
+ * #define MQTT_BENCHMARK_CLIENT_PAYLOAD_SIZE  ( 256U )
+ */
+
+/**
+ * @brief Number of PINGREQ and PINGRESP round trips measured by the MQTT ping
+ * round trip benchmark.
+ *
+ * #define MQTT_BENCHMARK_PING_COUNT  ( 20U )
+ */
+
+/**
+ * @brief Keep-alive interval in seconds of the MQTT context during the MQTT
+ * ping round trip benchmark. A PINGREQ is sent every interval, so the
+ * benchmark lasts about MQTT_BENCHMARK_PING_COUNT intervals. The CONNECT packet
+ * keeps MQTT_KEEP_ALIVE_INTERVAL_SECONDS.
+ *
+ * #define MQTT_BENCHMARK_PING_KEEP_ALIVE_SECONDS  ( 1U )
+ */
+
+/**
+ * @brief Number of QoS 0 messages a second connection floods the subscribed
+ * topic with in the MQTT slow consumer benchmark. The benchmark uses
+ * pSecondNetworkContext of the test parameters and lasts about
+ * MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT times MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS.
+ *
+ * #define MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT  ( 1000U )
+ */
+
+/**
+ * @brief Payload size in bytes of the MQTT slow consumer benchmark messages.
+ *
+ * #define MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE  ( 256U )
+ */
+
+/**
+ * @brief Artificial processing cost in milliseconds of each message received
+ * by the device in the MQTT slow consumer benchmark. Raise it, or
+ * MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT, to find when the keep-alive is missed.
+ *
+ * #define MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS  ( 10U )
+ */
+
+/**
+ * @brief Number of bytes received by the transport of a network context, in
+ * the socket or the TLS layer, and not yet read by the MQTT library.
+ *
+ * Without it, the MQTT slow consumer benchmark only reports the messages in
+ * flight between the flooding connection and the device. They may wait in the
+ * broker, the network or the device, and the benchmark cannot tell these
+ * apart. When defined, the benchmark samples it after every MQTT_ProcessLoop
+ * call and reports the peak as the device backlog. A TLS transport can add the
+ * decrypted bytes, such as mbedtls_ssl_get_bytes_avail(), to the bytes
+ * readable on its socket.
+ *
+ * #define MQTT_BENCHMARK_GET_RECV_PENDING( pNetworkContext )  PortGetRecvPending( pNetworkContext )
+ */
+
+/**
+ * @brief Number of retained messages published under one wildcard topic filter
+ * by the MQTT retained message storm benchmark. They are delivered at once
+ * when the benchmark subscribes to the topic filter, and cleared at the end.
+ *
+ * #define MQTT_BENCHMARK_RETAINED_COUNT  ( 100U )
+ */
+
+/**
+ * @brief Payload size in bytes of the MQTT retained message storm benchmark
+ * messages.
+ *
+ * #define MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE  ( 64U )
+ */
+
+/**
+ * @brief Free heap size in bytes of the platform. When defined, the MQTT
+ * retained message storm benchmark samples it during the delivery and reports
+ * the peak heap usage, which includes the allocations of the transport.
+ *
+ * #define MQTT_BENCHMARK_GET_FREE_HEAP_SIZE()  xPortGetFreeHeapSize()
+ */
+
+/**
+ * @brief Number of wills measured by the MQTT Last Will and Testament delivery
+ * latency benchmark. Each iteration connects a client with a will on
+ * pSecondNetworkContext of the test parameters and disconnects its transport
+ * abruptly.
+ *
+ * #define MQTT_BENCHMARK_LWT_ITERATIONS  ( 10U )
+ */
+
+/**
+ * @brief Topic of the requests of the MQTT coalesced packet receive benchmark.
+ * Set it to the burst-topic of the broker in tools/mqtt_broker, which answers
+ * a request with a burst of small publishes written at once. The benchmark
+ * reports the MQTT_ProcessLoop and transport recv calls needed to drain each
+ * burst. It is only run when this macro is defined.
+ *
+ * #define MQTT_BENCHMARK_BURST_TOPIC  "$test/burst"
+ */
+
+/**
+ * @brief Numbers of publishes of the bursts of the MQTT coalesced packet
+ * receive benchmark.
+ *
+ * #define MQTT_BENCHMARK_BURST_PACKET_COUNTS  { 1U, 4U, 16U, 64U }
+ */
+
+/**
+ * @brief Payload size in bytes of the publishes of the MQTT coalesced packet
+ * receive benchmark bursts.
+ *
+ * #define MQTT_BENCHMARK_BURST_PAYLOAD_SIZE  ( 16U )
+ */
+
+/**
+ * @brief Define this macro, together with MQTT_TEST_EXECUTE_BENCHMARK_TESTS, to
+ * run the MQTT process loop thread benchmark. A dedicated thread calls
+ * MQTT_ProcessLoop while publisher threads publish on the same MQTT context,
+ * every call serialized with a mutex. The benchmark validates that no message
+ * is corrupted, lost or reordered and reports the throughput and the lock
+ * contention. It requires the FRTest_MutexCreate, FRTest_MutexLock,
+ * FRTest_MutexTryLock, FRTest_MutexUnlock and FRTest_MutexDelete platform
+ * functions of platform_function.h.
+ *
+ * #define MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS
+ */
+
+/**
+ * @brief Number of publisher threads of the MQTT process loop thread
+ * benchmark. Each thread publishes MQTT_BENCHMARK_PUBLISH_COUNT QoS 1 messages.
+ *
+ * #define MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT  ( 3U )
+ */
+
+/**
+ * @brief Payload size in bytes of the MQTT process loop thread benchmark
+ * messages. It must be at least 5 bytes for the publisher index and the
+ * sequence number.
+ *
+ * #define MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE  ( 64U )
+ */
+
 /**
  * @brief Root certificate of the IoT Core.
  *
@@ -42,6 +42,11 @@ typedef void * FRTestThreadHandle_t;
  */
 typedef void ( * FRTestThreadFunction_t )( void * pParam );
 
+/**
+ * @brief Mutex handle data structure definition.
+ */
+typedef void * FRTestMutexHandle_t;
+
 /**
  * @brief Delay function to wait for at least specified amount of time.
  *
@@ -81,6 +86,46 @@ FRTestThreadHandle_t FRTest_ThreadCreate( FRTestThreadFunction_t threadFunc,
 int FRTest_ThreadTimedJoin( FRTestThreadHandle_t threadHandle,
                             uint32_t timeoutMs );
 
+/**
+ * @brief Mutex create function for test application.
+ *
+ * @note The mutex functions are only used by the MQTT process loop thread
+ * benchmark, enabled with MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS.
+ *
+ * @return NULL if create mutex failed. Otherwise, return the handle of the created mutex.
+ */
+FRTestMutexHandle_t FRTest_MutexCreate( void );
+
+/**
+ * @brief Mutex lock function to wait until the mutex is acquired.
+ *
+ * @param[in] mutexHandle The handle of the mutex created by FRTest_MutexCreate.
+ */
+void FRTest_MutexLock( FRTestMutexHandle_t mutexHandle );
+
+/**
+ * @brief Mutex try lock function to acquire the mutex without waiting.
+ *
+ * @param[in] mutexHandle The handle of the mutex created by FRTest_MutexCreate.
+ *
+ * @return 0 if the mutex is acquired. Other value if the mutex is held by another thread.
+ */
+int FRTest_MutexTryLock( FRTestMutexHandle_t mutexHandle );
+
+/**
+ * @brief Mutex unlock function to release the mutex acquired by the calling thread.
+ *
+ * @param[in] mutexHandle The handle of the mutex created by FRTest_MutexCreate.
+ */
+void FRTest_MutexUnlock( FRTestMutexHandle_t mutexHandle );
+
+/**
+ * @brief Mutex delete function to free the mutex created by FRTest_MutexCreate.
+ *
+ * @param[in] mutexHandle The handle of the mutex to be deleted.
+ */
+void FRTest_MutexDelete( FRTestMutexHandle_t mutexHandle );
+
 /**
  * @brief Malloc function to allocate memory for test.
  *
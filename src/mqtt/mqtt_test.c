@@ -29,6 +29,7 @@
 #if ( MQTT_TEST_ENABLED == 1 )
 
 #include <assert.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -179,6 +180,333 @@
  */
 #define MQTT_EXAMPLE_MESSAGE                "Hello World!"
 
+#ifdef MQTT_TEST_PACKET_TRACE
+
+/**
+ * @brief Number of packets kept in the packet trace ring. The oldest packets
+ * are overwritten when the ring is full.
+ */
+    #ifndef MQTT_TEST_PACKET_TRACE_ENTRY_COUNT
+        #define MQTT_TEST_PACKET_TRACE_ENTRY_COUNT    ( 256U )
+    #endif
+
+/**
+ * @brief Timestamp in microseconds of the traced packets.
+ *
+ * The default has the resolution of FRTest_GetTimeMs(). Define it to read a
+ * high resolution timer of the platform. The value may wrap around.
+ */
+    #ifndef MQTT_TEST_PACKET_TRACE_GET_TIME_US
+        #define MQTT_TEST_PACKET_TRACE_GET_TIME_US()    ( FRTest_GetTimeMs() * 1000U )
+    #endif
+
+/**
+ * @brief Size of a packet trace entry in the dump, and number of entries
+ * dumped on each line.
+ */
+    #define MQTT_TEST_PACKET_TRACE_DUMP_ENTRY_SIZE          ( 12U )
+    #define MQTT_TEST_PACKET_TRACE_DUMP_ENTRIES_PER_LINE    ( 4U )
+
+/**
+ * @brief Flags of a packet trace entry. The bits above
+ * MQTT_TEST_PACKET_TRACE_FLAG_RECEIVED hold the index of the connection: 0 for
+ * pNetworkContext, 1 for pSecondNetworkContext and 2 onwards for
+ * pBenchmarkNetworkContexts.
+ */
+    #define MQTT_TEST_PACKET_TRACE_FLAG_RECEIVED             ( 0x01U ) /**< @brief The packet is received from the broker. */
+    #define MQTT_TEST_PACKET_TRACE_CONNECTION_SHIFT          ( 1U )    /**< @brief Shift of the connection index in the flags. */
+
+/**
+ * @brief Number of connections traced, each with its own parsing state.
+ */
+    #ifdef MQTT_TEST_EXECUTE_BENCHMARK_TESTS
+        #define MQTT_TEST_PACKET_TRACE_CONNECTION_COUNT    MQTT_BENCHMARK_CLIENT_COUNT
+    #else
+        #define MQTT_TEST_PACKET_TRACE_CONNECTION_COUNT    ( 2U )
+    #endif
+
+#endif /* ifdef MQTT_TEST_PACKET_TRACE */
+
+/**
+ * @brief Print a message with the Unity output.
+ *
+ * Use UnityPrint for older version of Unity.
+ */
+#ifndef TEST_MESSAGE
+    #define TEST_MESSAGE( x )    UnityPrint( x )
+#endif
+
+#if defined( MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS ) && !defined( MQTT_TEST_EXECUTE_BENCHMARK_TESTS )
+    #error "MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS requires MQTT_TEST_EXECUTE_BENCHMARK_TESTS."
+#endif
+
+#ifdef MQTT_TEST_EXECUTE_BENCHMARK_TESTS
+
+/**
+ * @brief Length of the buffer used to format benchmark results.
+ */
+    #define MQTT_BENCHMARK_MESSAGE_LENGTH    ( 160U )
+
+/**
+ * @brief Number of messages published for each QoS and payload size by the
+ * publish throughput benchmark.
+ */
+    #ifndef MQTT_BENCHMARK_PUBLISH_COUNT
+        #define MQTT_BENCHMARK_PUBLISH_COUNT    ( 100U )
+    #endif
+
+/**
+ * @brief Payload sizes in bytes used by the publish throughput benchmark.
+ *
+ * Every size must not exceed MQTT_TEST_NETWORK_BUFFER_SIZE.
+ */
+    #ifndef MQTT_BENCHMARK_PAYLOAD_SIZES
+        #define MQTT_BENCHMARK_PAYLOAD_SIZES    { 16U, 256U, 1024U }
+    #endif
+
+/**
+ * @brief Timestamp in microseconds used to measure latencies.
+ *
+ * The default has the resolution of FRTest_GetTimeMs(). Define it to read a
+ * high resolution timer of the platform for sub-millisecond results.
+ */
+    #ifndef MQTT_BENCHMARK_GET_TIME_US
+        #define MQTT_BENCHMARK_GET_TIME_US()    ( FRTest_GetTimeMs() * 1000U )
+    #endif
+
+/**
+ * @brief Number of messages published for each QoS level by the latency
+ * benchmark.
+ */
+    #ifndef MQTT_BENCHMARK_LATENCY_SAMPLES
+        #define MQTT_BENCHMARK_LATENCY_SAMPLES    ( 100U )
+    #endif
+
+/**
+ * @brief Payload size in bytes of the latency benchmark messages. The payload
+ * starts with a sequence number and a timestamp.
+ */
+    #ifndef MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE
+        #define MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE    ( 16U )
+    #endif
+
+/**
+ * @brief Size of the sequence number and timestamp at the start of a latency
+ * benchmark payload.
+ */
+    #define MQTT_BENCHMARK_LATENCY_HEADER_SIZE    ( 2U * sizeof( uint32_t ) )
+
+/**
+ * @brief Payload size in bytes of the windowed publish, session restore and
+ * QoS 2 handshake benchmark messages.
+ */
+    #ifndef MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE
+        #define MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE    ( 256U )
+    #endif
+
+/**
+ * @brief Number of unacknowledged QoS 1 publishes restored by the session
+ * restore benchmark.
+ */
+    #ifndef MQTT_BENCHMARK_PENDING_PUBLISH_COUNT
+        #define MQTT_BENCHMARK_PENDING_PUBLISH_COUNT    OUTGOING_PUBLISH_RECORD_COUNT
+    #endif
+
+/**
+ * @brief Number of topic filters subscribed to by the subscription table
+ * benchmark. Every tenth topic filter has a single-level wildcard.
+ */
+    #ifndef MQTT_BENCHMARK_TOPIC_FILTER_COUNT
+        #define MQTT_BENCHMARK_TOPIC_FILTER_COUNT    ( 200U )
+    #endif
+
+/**
+ * @brief Maximum number of topic filters in a SUBSCRIBE packet of the
+ * subscription table benchmark. SUBSCRIBE packets are also limited to
+ * MQTT_TEST_NETWORK_BUFFER_SIZE.
+ */
+    #ifndef MQTT_BENCHMARK_MAX_FILTERS_PER_SUBSCRIBE
+        #define MQTT_BENCHMARK_MAX_FILTERS_PER_SUBSCRIBE    MQTT_BENCHMARK_TOPIC_FILTER_COUNT
+    #endif
+
+/**
+ * @brief Number of steps in which the subscription table benchmark grows the
+ * subscriptions, and messages used to measure the dispatch cost at each step.
+ */
+    #define MQTT_BENCHMARK_SUBSCRIPTION_STEPS       ( 4U )
+    #define MQTT_BENCHMARK_DISPATCH_MESSAGE_COUNT    ( 10U )
+
+    #if ( MQTT_BENCHMARK_TOPIC_FILTER_COUNT < ( 10U * MQTT_BENCHMARK_SUBSCRIPTION_STEPS ) )
+        #error "MQTT_BENCHMARK_TOPIC_FILTER_COUNT must give each step a wildcard topic filter."
+    #endif
+
+/**
+ * @brief Size of the buffer of a subscription table benchmark topic filter.
+ */
+    #define MQTT_BENCHMARK_TOPIC_FILTER_SIZE        ( TEST_MQTT_TOPIC_LENGTH + 20U )
+
+/**
+ * @brief Number of concurrent MQTT clients in the concurrent clients
+ * benchmark, including the connection of the test fixture.
+ */
+    #ifndef MQTT_BENCHMARK_CLIENT_COUNT
+        #define MQTT_BENCHMARK_CLIENT_COUNT    ( 2U )
+    #endif
+
+    #if ( MQTT_BENCHMARK_CLIENT_COUNT < 2U )
+        #error "MQTT_BENCHMARK_CLIENT_COUNT must be at least 2."
+    #endif
+
+/**
+ * @brief Payload size in bytes of the concurrent clients benchmark messages.
+ */
+    #ifndef MQTT_BENCHMARK_CLIENT_PAYLOAD_SIZE
+        #define MQTT_BENCHMARK_CLIENT_PAYLOAD_SIZE    ( 256U )
+    #endif
+
+/**
+ * @brief Number of PINGREQ and PINGRESP round trips measured by the ping
+ * round trip benchmark.
+ */
+    #ifndef MQTT_BENCHMARK_PING_COUNT
+        #define MQTT_BENCHMARK_PING_COUNT    ( 20U )
+    #endif
+
+/**
+ * @brief Keep-alive interval in seconds used by the MQTT context during the
+ * ping round trip benchmark. The CONNECT packet keeps
+ * MQTT_KEEP_ALIVE_INTERVAL_SECONDS, so the broker does not expect the pings
+ * more often.
+ */
+    #ifndef MQTT_BENCHMARK_PING_KEEP_ALIVE_SECONDS
+        #define MQTT_BENCHMARK_PING_KEEP_ALIVE_SECONDS    ( 1U )
+    #endif
+
+/**
+ * @brief Number of QoS 0 messages the second connection floods the subscribed
+ * topic with in the slow consumer benchmark.
+ */
+    #ifndef MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT
+        #define MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT    ( 1000U )
+    #endif
+
+/**
+ * @brief Payload size in bytes of the slow consumer benchmark messages.
+ */
+    #ifndef MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE
+        #define MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE    ( 256U )
+    #endif
+
+/**
+ * @brief Artificial processing cost in milliseconds of each message received
+ * by the slow consumer.
+ */
+    #ifndef MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS
+        #define MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS    ( 10U )
+    #endif
+
+/**
+ * @brief Number of retained messages published under one topic filter by the
+ * retained message storm benchmark.
+ */
+    #ifndef MQTT_BENCHMARK_RETAINED_COUNT
+        #define MQTT_BENCHMARK_RETAINED_COUNT    ( 100U )
+    #endif
+
+/**
+ * @brief Payload size in bytes of the retained message storm benchmark
+ * messages.
+ */
+    #ifndef MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE
+        #define MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE    ( 64U )
+    #endif
+
+/**
+ * @brief Prefix of the retained message storm benchmark topics, the wildcard
+ * topic filter matching them and the size of a topic buffer.
+ */
+    #define MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX           TEST_MQTT_TOPIC "/retained/"
+    #define MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX_LENGTH    ( sizeof( MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX ) - 1U )
+    #define MQTT_BENCHMARK_RETAINED_TOPIC_FILTER           MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX "#"
+    #define MQTT_BENCHMARK_RETAINED_TOPIC_SIZE             ( MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX_LENGTH + 12U )
+
+/**
+ * @brief Number of wills measured by the Last Will and Testament delivery
+ * latency benchmark.
+ */
+    #ifndef MQTT_BENCHMARK_LWT_ITERATIONS
+        #define MQTT_BENCHMARK_LWT_ITERATIONS    ( 10U )
+    #endif
+
+    #if ( MQTT_BENCHMARK_LWT_ITERATIONS < 1U )
+        #error "MQTT_BENCHMARK_LWT_ITERATIONS must be at least 1."
+    #endif
+
+/**
+ * @brief Topic of the requests of the coalesced packet receive benchmark. It
+ * must be the burst-topic of the broker in tools/mqtt_broker, which answers a
+ * QoS 0 publish on it with a burst of QoS 0 publishes written at once. The
+ * benchmark is only run when the topic is defined.
+ */
+    #ifdef MQTT_BENCHMARK_BURST_TOPIC
+
+        #define MQTT_BENCHMARK_BURST_TOPIC_LENGTH    ( ( uint16_t ) ( sizeof( MQTT_BENCHMARK_BURST_TOPIC ) - 1U ) )
+
+/**
+ * @brief Numbers of packets of the bursts of the coalesced packet receive
+ * benchmark.
+ */
+        #ifndef MQTT_BENCHMARK_BURST_PACKET_COUNTS
+            #define MQTT_BENCHMARK_BURST_PACKET_COUNTS    { 1U, 4U, 16U, 64U }
+        #endif
+
+/**
+ * @brief Payload size in bytes of the publishes of the coalesced packet
+ * receive benchmark bursts.
+ */
+        #ifndef MQTT_BENCHMARK_BURST_PAYLOAD_SIZE
+            #define MQTT_BENCHMARK_BURST_PAYLOAD_SIZE    ( 16U )
+        #endif
+
+    #endif /* ifdef MQTT_BENCHMARK_BURST_TOPIC */
+
+    #ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS
+
+/**
+ * @brief Number of publisher threads of the process loop thread benchmark.
+ */
+        #ifndef MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT
+            #define MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT    ( 3U )
+        #endif
+
+/**
+ * @brief Payload size in bytes of the process loop thread benchmark messages.
+ */
+        #ifndef MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE
+            #define MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE    ( 64U )
+        #endif
+
+/**
+ * @brief Size of the header of the process loop thread benchmark payload,
+ * made of the publisher index and the message sequence number.
+ */
+        #define MQTT_BENCHMARK_PUBLISHER_HEADER_SIZE    ( 1U + sizeof( uint32_t ) )
+
+        #if ( MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT > 255U )
+            #error "MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT must fit in the payload header."
+        #endif
+
+    #endif /* ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS */
+
+/**
+ * @brief Timeout in milliseconds to wait for a benchmark client thread.
+ */
+    #ifndef MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS
+        #define MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS    ( 60000U )
+    #endif
+
+#endif /* ifdef MQTT_TEST_EXECUTE_BENCHMARK_TESTS */
+
 /*-----------------------------------------------------------*/
 
 #if ( MQTT_TEST_ENABLED == 1 )
@@ -277,10 +605,17 @@ static bool receivedPubComp = false;
 static bool receivedRetainedMessage = false;
 
 /**
- * @brief Represents incoming PUBLISH information.
+ * @brief Represents the latest incoming PUBLISH information. The topic name
+ * and payload point to #receivedMessageBuffer.
  */
 static MQTTPublishInfo_t incomingInfo;
 
+/**
+ * @brief Copy of the topic name and payload of the latest incoming PUBLISH.
+ * A PUBLISH packet fits in the network buffer, so any message fits here.
+ */
+static uint8_t receivedMessageBuffer[ MQTT_TEST_NETWORK_BUFFER_SIZE ];
+
 /**
  * @brief Disconnect when receiving this packet type. Used for session
  * restoration tests.
@@ -296,100 +631,568 @@ static uint8_t packetTypeForDisconnection = MQTT_PACKET_TYPE_INVALID;
  */
 static int clientIdRandNumber;
 
-/*-----------------------------------------------------------*/
+/**
+ * @brief Callback used by a benchmark to handle the incoming packets instead
+ * of the test event callback.
+ */
+static MQTTEventCallback_t benchmarkEventCallback = NULL;
+
+#ifdef MQTT_TEST_REUSE_CONNECTION
 
 /**
- * @brief Sends an MQTT CONNECT packet over the already connected TCP socket.
- *
- * @param[in] pContext MQTT context pointer.
- * @param[in] pNetworkContext Network context for mqtt connection
- * @param[in] createCleanSession Creates a new MQTT session if true.
- * If false, tries to establish the existing session if there was session
- * already present in broker.
- * @param[out] pSessionPresent Session was already present in the broker or not.
- * Session present response is obtained from the CONNACK from broker.
+ * @brief Whether the running MQTT test can share its session with other
+ * tests. Set by the test group runner.
  */
-static void establishMqttSession( MQTTContext_t * pContext,
-                                  void * pNetworkContext,
-                                  bool createCleanSession,
-                                  bool * pSessionPresent );
+    static bool sessionReusable = false;
 
 /**
- * @brief Handler for incoming acknowledgement packets from the broker.
- * @param[in] pPacketInfo Info for the incoming acknowledgement packet.
- * @param[in] packetIdentifier The ID of the incoming packet.
+ * @brief Whether a session kept by a previous test is still connected.
  */
-static void handleAckEvents( MQTTPacketInfo_t * pPacketInfo,
-                             uint16_t packetIdentifier );
+    static bool sharedSessionConnected = false;
+
+#endif /* ifdef MQTT_TEST_REUSE_CONNECTION */
 
 /**
- * @brief The application callback function that is expected to be invoked by the
- * MQTT library for incoming publish and incoming acks received over the network.
- *
- * @param[in] pContext MQTT context pointer.
- * @param[in] pPacketInfo Packet Info pointer for the incoming packet.
- * @param[in] pDeserializedInfo Deserialized information from the incoming packet.
+ * @brief Whether the test context is connected by connectTestSession.
  */
-static void eventCallback( MQTTContext_t * pContext,
-                           MQTTPacketInfo_t * pPacketInfo,
-                           MQTTDeserializedInfo_t * pDeserializedInfo );
+static bool testSessionConnected = false;
+
+#ifdef MQTT_TEST_TIME_WARP_FACTOR
 
 /**
- * @brief Implementation of TransportSend_t interface that terminates the TLS
- * and TCP connection with the broker and returns failure.
+ * @brief Whether the running test uses the warped clock. Set by the setup of
+ * each test group: the MQTT tests use it, the MQTT benchmarks measure real
+ * time.
+ */
+    static bool timeWarpEnabled = false;
+
+/**
+ * @brief Time of testParam.pGetTimeMs when RunMqttTest starts.
+ */
+    static uint32_t warpBaseTimeMs = 0;
+
+/**
+ * @brief Time function running MQTT_TEST_TIME_WARP_FACTOR times faster than
+ * testParam.pGetTimeMs.
  *
- * @param[in] pNetworkContext The context associated with the network connection
- * to be disconnected.
- * @param[in] pBuffer This parameter is ignored.
- * @param[in] bytesToRecv This parameter is ignored.
+ * It is passed to MQTT_Init and used for the waits of the test cases, so the
+ * keep-alive, PINGRESP, CONNACK and test timeouts expire sooner in real time.
+ * Only the time elapsed since warpBaseTimeMs is scaled, so that the warped
+ * time starts from 0 and does not wrap around sooner than the real time.
+ */
+    static uint32_t getWarpedTimeMs( void )
+    {
+        return ( testParam.pGetTimeMs() - warpBaseTimeMs ) * MQTT_TEST_TIME_WARP_FACTOR;
+    }
+
+    #define MQTT_TEST_TIME_FUNCTION    ( ( timeWarpEnabled == true ) ? getWarpedTimeMs : testParam.pGetTimeMs )
+    #define MQTT_TEST_GET_TIME_MS()    ( ( timeWarpEnabled == true ) ? getWarpedTimeMs() : FRTest_GetTimeMs() )
+#else
+    #define MQTT_TEST_TIME_FUNCTION    testParam.pGetTimeMs
+    #define MQTT_TEST_GET_TIME_MS()    FRTest_GetTimeMs()
+#endif /* ifdef MQTT_TEST_TIME_WARP_FACTOR */
+
+#ifdef MQTT_TEST_PACKET_TRACE
+
+/**
+ * @brief MQTT packet sent or received by a test session.
+ */
+typedef struct PacketTraceEntry
+{
+    uint32_t timestampUs;     /**< @brief Time the first byte of the packet is sent or received. */
+    uint32_t remainingLength; /**< @brief Remaining length of the packet. */
+    uint16_t packetId;        /**< @brief Packet identifier, 0 if the packet has none. */
+    uint8_t header;           /**< @brief First byte of the fixed header, the packet type and flags. */
+    uint8_t flags;            /**< @brief MQTT_TEST_PACKET_TRACE_FLAG_* flags. */
+} PacketTraceEntry_t;
+
+/**
+ * @brief Packet parsing state of one direction of a traced connection.
  *
- * @return -1 to represent failure.
+ * The packets are parsed from the bytes passed to the transport so that they
+ * are traced however the MQTT library splits its transport calls. Only the
+ * fixed header and the bytes up to the packet identifier are parsed.
  */
-static int32_t failedRecv( NetworkContext_t * pNetworkContext,
-                           void * pBuffer,
-                           size_t bytesToRecv );
+typedef struct PacketTraceStream
+{
+    uint32_t startTimeUs;     /**< @brief Time the first byte of the current packet is traced. */
+    uint32_t remainingLength; /**< @brief Remaining length of the current packet. */
+    uint32_t multiplier;      /**< @brief Multiplier of the next remaining length byte. */
+    uint32_t bodyOffset;      /**< @brief Bytes of the current packet traced after the fixed header. */
+    uint32_t parseLength;     /**< @brief Bytes after the fixed header to parse to find the packet identifier. */
+    uint16_t lastBytes;       /**< @brief Last two bytes parsed, the packet identifier once parseLength bytes are parsed. */
+    uint8_t header;           /**< @brief First byte of the fixed header of the current packet. */
+    uint8_t state;            /**< @brief Whether the header, the remaining length or the rest of the packet is parsed. */
+} PacketTraceStream_t;
 
+/**
+ * @brief States of a #PacketTraceStream_t.
+ */
+    #define PACKET_TRACE_STATE_HEADER             ( 0U )
+    #define PACKET_TRACE_STATE_REMAINING_LENGTH   ( 1U )
+    #define PACKET_TRACE_STATE_BODY               ( 2U )
 
 /**
- * @brief Helper function to start a new persistent session.
- * It terminates the existing "clean session", and creates a new connection
- * with the "clean session" flag set to 0 to create a persistent session
- * with the broker.
+ * @brief Ring of the latest traced packets.
  */
-static void startPersistentSession();
+static PacketTraceEntry_t packetTrace[ MQTT_TEST_PACKET_TRACE_ENTRY_COUNT ];
 
 /**
- * @brief Helper function to resume connection in persistent session
- * with the broker.
- * It resumes the session with the broker by establishing a new connection
- * with the "clean session" flag set to 0.
+ * @brief Total number of packets traced since the test started. The next entry
+ * is written at packetTraceTotal modulo MQTT_TEST_PACKET_TRACE_ENTRY_COUNT.
  */
-static void resumePersistentSession();
+static uint32_t packetTraceTotal = 0;
 
+/**
+ * @brief Parsing state of each direction of each traced connection, indexed by
+ * the entry flags.
+ */
+static PacketTraceStream_t packetTraceStreams[ 2U * MQTT_TEST_PACKET_TRACE_CONNECTION_COUNT ];
 
 /**
- * @brief Test group for transport interface test.
+ * @brief Mutex protecting the ring from the benchmark threads tracing their
+ * own connections concurrently.
  */
-TEST_GROUP( MqttTest );
+static FRTestMutexHandle_t packetTraceMutex = NULL;
+
 /*-----------------------------------------------------------*/
 
-static void establishMqttSession( MQTTContext_t * pContext,
-                                  void * pNetworkContext,
-                                  bool createCleanSession,
-                                  bool * pSessionPresent )
+/**
+ * @brief Remove all the packets from the packet trace. The parsing state is
+ * kept, as a session shared with the previous test may still be connected.
+ * The mutex is created on the first reset, before any test thread runs.
+ */
+static void resetPacketTrace( void )
 {
-    MQTTConnectInfo_t connectInfo;
-    TransportInterface_t transport;
-    MQTTFixedBuffer_t networkBuffer;
-    MQTTPublishInfo_t lwtInfo;
+    if( packetTraceMutex == NULL )
+    {
+        packetTraceMutex = FRTest_MutexCreate();
+        TEST_ASSERT_NOT_NULL_MESSAGE( packetTraceMutex, "Create the packet trace mutex failed." );
+    }
 
-    assert( pContext != NULL );
+    packetTraceTotal = 0;
+}
 
-    /* The network buffer must remain valid for the lifetime of the MQTT context. */
-    static uint8_t buffer[ MQTT_TEST_NETWORK_BUFFER_SIZE ];
+/*-----------------------------------------------------------*/
 
-    /* Buffer for storing client ID with random integer.
-     * Note: Size value is chosen to accommodate both LWT and non-LWT client ID
+/**
+ * @brief Get the entry flags of the packets sent or received over a network
+ * context.
+ */
+static uint8_t getPacketTraceFlags( const NetworkContext_t * pNetworkContext,
+                                    bool received )
+{
+    uint8_t flags = ( received == true ) ? MQTT_TEST_PACKET_TRACE_FLAG_RECEIVED : 0U;
+    size_t connection = 1U;
+    size_t i;
+
+    if( pNetworkContext == testParam.pNetworkContext )
+    {
+        connection = 0U;
+    }
+
+    for( i = 0; ( i < testParam.benchmarkNetworkContextCount ) && ( ( i + 2U ) < MQTT_TEST_PACKET_TRACE_CONNECTION_COUNT ); i++ )
+    {
+        if( pNetworkContext == testParam.pBenchmarkNetworkContexts[ i ] )
+        {
+            connection = i + 2U;
+        }
+    }
+
+    return ( uint8_t ) ( flags | ( connection << MQTT_TEST_PACKET_TRACE_CONNECTION_SHIFT ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Parse bytes sent or received over a traced connection and add the
+ * completed packets to the trace.
+ */
+static void tracePacketBytes( uint8_t flags,
+                              uint32_t timeUs,
+                              const uint8_t * pBytes,
+                              size_t length )
+{
+    PacketTraceStream_t * pStream = &packetTraceStreams[ flags ];
+    PacketTraceEntry_t * pEntry;
+    size_t skipLength;
+    size_t i = 0;
+    bool completed;
+
+    while( i < length )
+    {
+        completed = false;
+
+        if( pStream->state == PACKET_TRACE_STATE_HEADER )
+        {
+            pStream->header = pBytes[ i ];
+            pStream->startTimeUs = timeUs;
+            pStream->remainingLength = 0U;
+            pStream->multiplier = 1U;
+            pStream->bodyOffset = 0U;
+            pStream->lastBytes = 0U;
+
+            /* PUBLISH packets with QoS 1 or 2 have the packet identifier
+             * after the topic, acknowledgements and (UN)SUBSCRIBE packets
+             * start with it. */
+            if( ( pStream->header & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+            {
+                pStream->parseLength = ( ( pStream->header & 0x06U ) != 0U ) ? 2U : 0U;
+            }
+            else if( ( ( pStream->header >> 4 ) >= ( MQTT_PACKET_TYPE_PUBACK >> 4 ) ) &&
+                     ( ( pStream->header >> 4 ) <= ( MQTT_PACKET_TYPE_UNSUBACK >> 4 ) ) )
+            {
+                pStream->parseLength = 2U;
+            }
+            else
+            {
+                pStream->parseLength = 0U;
+            }
+
+            pStream->state = PACKET_TRACE_STATE_REMAINING_LENGTH;
+            i++;
+        }
+        else if( pStream->state == PACKET_TRACE_STATE_REMAINING_LENGTH )
+        {
+            pStream->remainingLength += ( uint32_t ) ( pBytes[ i ] & 0x7FU ) * pStream->multiplier;
+            pStream->multiplier *= 128U;
+
+            if( ( pBytes[ i ] & 0x80U ) == 0U )
+            {
+                pStream->state = PACKET_TRACE_STATE_BODY;
+                completed = ( pStream->remainingLength == 0U );
+            }
+
+            i++;
+        }
+        else if( pStream->bodyOffset < pStream->parseLength )
+        {
+            pStream->lastBytes = ( uint16_t ) ( ( pStream->lastBytes << 8 ) | pBytes[ i ] );
+            pStream->bodyOffset++;
+
+            /* The topic length of a PUBLISH gives the packet identifier offset. */
+            if( ( ( pStream->header & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH ) &&
+                ( pStream->parseLength == 2U ) && ( pStream->bodyOffset == 2U ) )
+            {
+                pStream->parseLength = 4U + pStream->lastBytes;
+            }
+
+            completed = ( pStream->bodyOffset >= pStream->remainingLength );
+            i++;
+        }
+        else
+        {
+            skipLength = pStream->remainingLength - pStream->bodyOffset;
+
+            if( skipLength > ( length - i ) )
+            {
+                skipLength = length - i;
+            }
+
+            pStream->bodyOffset += ( uint32_t ) skipLength;
+            completed = ( pStream->bodyOffset >= pStream->remainingLength );
+            i += skipLength;
+        }
+
+        if( completed == true )
+        {
+            FRTest_MutexLock( packetTraceMutex );
+
+            pEntry = &packetTrace[ packetTraceTotal % MQTT_TEST_PACKET_TRACE_ENTRY_COUNT ];
+            pEntry->timestampUs = pStream->startTimeUs;
+            pEntry->remainingLength = pStream->remainingLength;
+            pEntry->packetId = ( ( pStream->parseLength > 0U ) && ( pStream->bodyOffset >= pStream->parseLength ) ) ?
+                               pStream->lastBytes : 0U;
+            pEntry->header = pStream->header;
+            pEntry->flags = flags;
+            packetTraceTotal++;
+
+            FRTest_MutexUnlock( packetTraceMutex );
+
+            pStream->state = PACKET_TRACE_STATE_HEADER;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Transport send function tracing the packets sent.
+ */
+static int32_t traceSend( NetworkContext_t * pNetworkContext,
+                          const void * pBuffer,
+                          size_t bytesToSend )
+{
+    uint32_t timeUs = MQTT_TEST_PACKET_TRACE_GET_TIME_US();
+    int32_t bytesSent = testParam.pTransport->send( pNetworkContext, pBuffer, bytesToSend );
+
+    if( bytesSent > 0 )
+    {
+        tracePacketBytes( getPacketTraceFlags( pNetworkContext, false ), timeUs, pBuffer, ( size_t ) bytesSent );
+    }
+
+    return bytesSent;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Transport receive function tracing the packets received.
+ */
+static int32_t traceRecv( NetworkContext_t * pNetworkContext,
+                          void * pBuffer,
+                          size_t bytesToRecv )
+{
+    int32_t bytesReceived = testParam.pTransport->recv( pNetworkContext, pBuffer, bytesToRecv );
+
+    if( bytesReceived > 0 )
+    {
+        tracePacketBytes( getPacketTraceFlags( pNetworkContext, true ), MQTT_TEST_PACKET_TRACE_GET_TIME_US(),
+                          pBuffer, ( size_t ) bytesReceived );
+    }
+
+    return bytesReceived;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Transport writev function tracing the packets sent.
+ */
+static int32_t traceWritev( NetworkContext_t * pNetworkContext,
+                            TransportOutVector_t * pIoVec,
+                            size_t ioVecCount )
+{
+    uint32_t timeUs = MQTT_TEST_PACKET_TRACE_GET_TIME_US();
+    int32_t bytesSent = testParam.pTransport->writev( pNetworkContext, pIoVec, ioVecCount );
+    size_t tracedLength = 0;
+    size_t length;
+    size_t i;
+
+    for( i = 0; ( i < ioVecCount ) && ( bytesSent > 0 ) && ( tracedLength < ( size_t ) bytesSent ); i++ )
+    {
+        length = pIoVec[ i ].iov_len;
+
+        if( length > ( ( size_t ) bytesSent - tracedLength ) )
+        {
+            length = ( size_t ) bytesSent - tracedLength;
+        }
+
+        tracePacketBytes( getPacketTraceFlags( pNetworkContext, false ), timeUs, pIoVec[ i ].iov_base, length );
+        tracedLength += length;
+    }
+
+    return bytesSent;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Print the packet trace with the Unity output.
+ *
+ * The dump starts with a MQTT_TRACE_BEGIN line giving the number of entries
+ * and of overwritten entries. Each MQTT_TRACE line holds up to
+ * MQTT_TEST_PACKET_TRACE_DUMP_ENTRIES_PER_LINE entries from the oldest, each
+ * made of the big endian timestamp, remaining length, packet identifier,
+ * header byte and flags in hexadecimal. tools/mqtt_trace converts the dump to
+ * pcap or JSON.
+ */
+static void dumpPacketTrace( void )
+{
+    char line[ sizeof( "MQTT_TRACE " ) +
+               ( 2U * MQTT_TEST_PACKET_TRACE_DUMP_ENTRY_SIZE * MQTT_TEST_PACKET_TRACE_DUMP_ENTRIES_PER_LINE ) ];
+    uint8_t bytes[ MQTT_TEST_PACKET_TRACE_DUMP_ENTRY_SIZE ];
+    const PacketTraceEntry_t * pEntry;
+    uint32_t entryCount = packetTraceTotal;
+    uint32_t index = 0;
+    size_t lineLength = 0;
+    size_t i;
+
+    if( entryCount > MQTT_TEST_PACKET_TRACE_ENTRY_COUNT )
+    {
+        entryCount = MQTT_TEST_PACKET_TRACE_ENTRY_COUNT;
+        index = packetTraceTotal - MQTT_TEST_PACKET_TRACE_ENTRY_COUNT;
+    }
+
+    ( void ) snprintf( line, sizeof( line ), "MQTT_TRACE_BEGIN %u %u",
+                       ( unsigned int ) entryCount, ( unsigned int ) ( packetTraceTotal - entryCount ) );
+    TEST_MESSAGE( line );
+
+    for( ; index < packetTraceTotal; index++ )
+    {
+        pEntry = &packetTrace[ index % MQTT_TEST_PACKET_TRACE_ENTRY_COUNT ];
+
+        bytes[ 0 ] = ( uint8_t ) ( pEntry->timestampUs >> 24 );
+        bytes[ 1 ] = ( uint8_t ) ( pEntry->timestampUs >> 16 );
+        bytes[ 2 ] = ( uint8_t ) ( pEntry->timestampUs >> 8 );
+        bytes[ 3 ] = ( uint8_t ) pEntry->timestampUs;
+        bytes[ 4 ] = ( uint8_t ) ( pEntry->remainingLength >> 24 );
+        bytes[ 5 ] = ( uint8_t ) ( pEntry->remainingLength >> 16 );
+        bytes[ 6 ] = ( uint8_t ) ( pEntry->remainingLength >> 8 );
+        bytes[ 7 ] = ( uint8_t ) pEntry->remainingLength;
+        bytes[ 8 ] = ( uint8_t ) ( pEntry->packetId >> 8 );
+        bytes[ 9 ] = ( uint8_t ) pEntry->packetId;
+        bytes[ 10 ] = pEntry->header;
+        bytes[ 11 ] = pEntry->flags;
+
+        if( lineLength == 0U )
+        {
+            lineLength = ( size_t ) snprintf( line, sizeof( line ), "MQTT_TRACE " );
+        }
+
+        for( i = 0; i < sizeof( bytes ); i++ )
+        {
+            lineLength += ( size_t ) snprintf( &line[ lineLength ], sizeof( line ) - lineLength, "%02x", bytes[ i ] );
+        }
+
+        if( ( lineLength == ( sizeof( line ) - 1U ) ) || ( ( index + 1U ) == packetTraceTotal ) )
+        {
+            TEST_MESSAGE( line );
+            lineLength = 0;
+        }
+    }
+
+    TEST_MESSAGE( "MQTT_TRACE_END" );
+}
+
+    #define MQTT_TEST_TRANSPORT_SEND      traceSend
+    #define MQTT_TEST_TRANSPORT_RECV      traceRecv
+    #define MQTT_TEST_TRANSPORT_WRITEV    ( ( testParam.pTransport->writev != NULL ) ? traceWritev : NULL )
+#else
+    #define MQTT_TEST_TRANSPORT_SEND      testParam.pTransport->send
+    #define MQTT_TEST_TRANSPORT_RECV      testParam.pTransport->recv
+    #define MQTT_TEST_TRANSPORT_WRITEV    testParam.pTransport->writev
+#endif /* ifdef MQTT_TEST_PACKET_TRACE */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sends an MQTT CONNECT packet over the already connected TCP socket.
+ *
+ * @param[in] pContext MQTT context pointer.
+ * @param[in] pNetworkContext Network context for mqtt connection
+ * @param[in] createCleanSession Creates a new MQTT session if true.
+ * If false, tries to establish the existing session if there was session
+ * already present in broker.
+ * @param[out] pSessionPresent Session was already present in the broker or not.
+ * Session present response is obtained from the CONNACK from broker.
+ */
+static void establishMqttSession( MQTTContext_t * pContext,
+                                  void * pNetworkContext,
+                                  bool createCleanSession,
+                                  bool * pSessionPresent );
+
+/**
+ * @brief Handler for incoming acknowledgement packets from the broker.
+ * @param[in] pPacketInfo Info for the incoming acknowledgement packet.
+ * @param[in] packetIdentifier The ID of the incoming packet.
+ */
+static void handleAckEvents( MQTTPacketInfo_t * pPacketInfo,
+                             uint16_t packetIdentifier );
+
+/**
+ * @brief Forget the latest incoming PUBLISH.
+ */
+static void resetReceivedMessages( void )
+{
+    memset( &incomingInfo, 0u, sizeof( MQTTPublishInfo_t ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy an incoming PUBLISH into #incomingInfo, with its topic name and
+ * payload in #receivedMessageBuffer.
+ */
+static void captureReceivedMessage( const MQTTPublishInfo_t * pPublishInfo )
+{
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( receivedMessageBuffer ),
+                                              pPublishInfo->topicNameLength + pPublishInfo->payloadLength,
+                                              "Incoming PUBLISH exceeds the received message buffer." );
+
+    memcpy( &incomingInfo, pPublishInfo, sizeof( MQTTPublishInfo_t ) );
+
+    memcpy( receivedMessageBuffer, pPublishInfo->pTopicName, pPublishInfo->topicNameLength );
+    incomingInfo.pTopicName = ( const char * ) receivedMessageBuffer;
+
+    if( pPublishInfo->payloadLength > 0U )
+    {
+        memcpy( &receivedMessageBuffer[ pPublishInfo->topicNameLength ], pPublishInfo->pPayload, pPublishInfo->payloadLength );
+    }
+
+    incomingInfo.pPayload = &receivedMessageBuffer[ pPublishInfo->topicNameLength ];
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The application callback function that is expected to be invoked by the
+ * MQTT library for incoming publish and incoming acks received over the network.
+ *
+ * @param[in] pContext MQTT context pointer.
+ * @param[in] pPacketInfo Packet Info pointer for the incoming packet.
+ * @param[in] pDeserializedInfo Deserialized information from the incoming packet.
+ */
+static void eventCallback( MQTTContext_t * pContext,
+                           MQTTPacketInfo_t * pPacketInfo,
+                           MQTTDeserializedInfo_t * pDeserializedInfo );
+
+/**
+ * @brief Implementation of TransportSend_t interface that terminates the TLS
+ * and TCP connection with the broker and returns failure.
+ *
+ * @param[in] pNetworkContext The context associated with the network connection
+ * to be disconnected.
+ * @param[in] pBuffer This parameter is ignored.
+ * @param[in] bytesToRecv This parameter is ignored.
+ *
+ * @return -1 to represent failure.
+ */
+static int32_t failedRecv( NetworkContext_t * pNetworkContext,
+                           void * pBuffer,
+                           size_t bytesToRecv );
+
+
+/**
+ * @brief Helper function to start a new persistent session.
+ * It terminates the existing "clean session", and creates a new connection
+ * with the "clean session" flag set to 0 to create a persistent session
+ * with the broker.
+ */
+static void startPersistentSession();
+
+/**
+ * @brief Helper function to resume connection in persistent session
+ * with the broker.
+ * It resumes the session with the broker by establishing a new connection
+ * with the "clean session" flag set to 0.
+ */
+static void resumePersistentSession();
+
+
+/**
+ * @brief Test group for transport interface test.
+ */
+TEST_GROUP( MqttTest );
+/*-----------------------------------------------------------*/
+
+static void establishMqttSession( MQTTContext_t * pContext,
+                                  void * pNetworkContext,
+                                  bool createCleanSession,
+                                  bool * pSessionPresent )
+{
+    MQTTConnectInfo_t connectInfo;
+    TransportInterface_t transport;
+    MQTTFixedBuffer_t networkBuffer;
+    MQTTPublishInfo_t lwtInfo;
+
+    assert( pContext != NULL );
+
+    /* The network buffer must remain valid for the lifetime of the MQTT context. */
+    static uint8_t buffer[ MQTT_TEST_NETWORK_BUFFER_SIZE ];
+
+    /* Buffer for storing client ID with random integer.
+     * Note: Size value is chosen to accommodate both LWT and non-LWT client ID
      * strings along with NULL character.*/
     char clientIdBuffer[ TEST_CLIENT_IDENTIFIER_LWT_LENGTH +
                          MAX_RAND_NUMBER_DIGITS_FOR_CLIENT_ID + 1u ] = { 0 };
@@ -402,9 +1205,15 @@ static void establishMqttSession( MQTTContext_t * pContext,
     networkBuffer.size = MQTT_TEST_NETWORK_BUFFER_SIZE;
 
     transport.pNetworkContext = pNetworkContext;
-    transport.send = testParam.pTransport->send;
-    transport.recv = testParam.pTransport->recv;
-    transport.writev = testParam.pTransport->writev;
+    transport.send = MQTT_TEST_TRANSPORT_SEND;
+    transport.recv = MQTT_TEST_TRANSPORT_RECV;
+    transport.writev = MQTT_TEST_TRANSPORT_WRITEV;
+
+    #ifdef MQTT_TEST_PACKET_TRACE
+        /* Parse the new connection from the first packet. */
+        memset( &packetTraceStreams[ getPacketTraceFlags( pNetworkContext, false ) ], 0x00, sizeof( PacketTraceStream_t ) );
+        memset( &packetTraceStreams[ getPacketTraceFlags( pNetworkContext, true ) ], 0x00, sizeof( PacketTraceStream_t ) );
+    #endif
 
     /* Clear the state of the MQTT context when creating a clean session. */
     if( createCleanSession == true )
@@ -412,7 +1221,7 @@ static void establishMqttSession( MQTTContext_t * pContext,
         /* Initialize MQTT library. */
         TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_Init( pContext,
                                                    &transport,
-                                                   testParam.pGetTimeMs,
+                                                   MQTT_TEST_TIME_FUNCTION,
                                                    eventCallback,
                                                    &networkBuffer ) );
 
@@ -502,6 +1311,11 @@ static void eventCallback( MQTTContext_t * pContext,
          * across network connection. */
         ( *testParam.pNetworkDisconnect )( testParam.pNetworkContext );
     }
+    else if( benchmarkEventCallback != NULL )
+    {
+        /* The benchmark handles the packet without capturing it. */
+        benchmarkEventCallback( pContext, pPacketInfo, pDeserializedInfo );
+    }
     else
     {
         /* Handle incoming publish. The lower 4 bits of the publish packet
@@ -514,16 +1328,7 @@ static void eventCallback( MQTTContext_t * pContext,
 
             /* Cache information about the incoming PUBLISH message to process
              * in test case. */
-            memcpy( &incomingInfo, pPublishInfo, sizeof( MQTTPublishInfo_t ) );
-            incomingInfo.pTopicName = NULL;
-            incomingInfo.pPayload = NULL;
-            /* Allocate buffers and copy information of topic name and payload. */
-            incomingInfo.pTopicName = malloc( pPublishInfo->topicNameLength );
-            TEST_ASSERT_NOT_NULL( incomingInfo.pTopicName );
-            memcpy( ( void * ) incomingInfo.pTopicName, pPublishInfo->pTopicName, pPublishInfo->topicNameLength );
-            incomingInfo.pPayload = malloc( pPublishInfo->payloadLength );
-            TEST_ASSERT_NOT_NULL( incomingInfo.pPayload );
-            memcpy( ( void * ) incomingInfo.pPayload, pPublishInfo->pPayload, pPublishInfo->payloadLength );
+            captureReceivedMessage( pPublishInfo );
 
             /* Update the global variable if the incoming PUBLISH packet
              * represents a retained message. */
@@ -763,9 +1568,9 @@ static MQTTStatus_t publishToTopic( MQTTContext_t * pContext,
 /*-----------------------------------------------------------*/
 
 /**
- * @brief Test setup function for MQTT tests.
+ * @brief Reset the file-scoped state used by a test case.
  */
-TEST_SETUP( MqttTest )
+static void resetTestState( void )
 {
     /* Reset file-scoped global variables. */
     receivedSubAck = false;
@@ -778,7 +1583,23 @@ TEST_SETUP( MqttTest )
     persistentSession = false;
     useLWTClientIdentifier = false;
     packetTypeForDisconnection = MQTT_PACKET_TYPE_INVALID;
-    memset( &incomingInfo, 0u, sizeof( MQTTPublishInfo_t ) );
+    benchmarkEventCallback = NULL;
+    resetReceivedMessages();
+
+    #ifdef MQTT_TEST_PACKET_TRACE
+        resetPacketTrace();
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Reset the test state and connect to the MQTT broker with a clean
+ * session.
+ */
+static void connectTestSession( void )
+{
+    resetTestState();
 
     /* Generate a random number to use in the client identifier. */
     clientIdRandNumber = ( FRTest_GenerateRandInt() % ( MAX_RAND_NUMBER_FOR_CLIENT_ID + 1u ) );
@@ -788,6 +1609,7 @@ TEST_SETUP( MqttTest )
     TEST_ASSERT_EQUAL( NETWORK_CONNECT_SUCCESS, ( *testParam.pNetworkConnect )( testParam.pNetworkContext,
                                                                                 &testHostInfo,
                                                                                 testParam.pNetworkCredentials ) );
+    testSessionConnected = true;
 
     /* Establish MQTT session on top of the TCP+TLS connection. */
     establishMqttSession( &context, testParam.pNetworkContext, true, &persistentSession );
@@ -796,27 +1618,17 @@ TEST_SETUP( MqttTest )
 /*-----------------------------------------------------------*/
 
 /**
- * @brief Test tear down function for MQTT tests.
+ * @brief Disconnect from the MQTT broker.
  */
-TEST_TEAR_DOWN( MqttTest )
+static void disconnectTestSession( void )
 {
     MQTTStatus_t mqttStatus;
 
-    /* Free memory, if allocated during test case execution. */
-    if( incomingInfo.pTopicName != NULL )
-    {
-        free( ( void * ) incomingInfo.pTopicName );
-    }
-
-    if( incomingInfo.pPayload != NULL )
-    {
-        free( ( void * ) incomingInfo.pPayload );
-    }
-
     /* Terminate MQTT connection. */
     mqttStatus = MQTT_Disconnect( &context );
 
     ( *testParam.pNetworkDisconnect )( testParam.pNetworkContext );
+    testSessionConnected = false;
 
     /* Make any assertions at the end so that all memory is deallocated before
      * the end of this function. */
@@ -825,6 +1637,88 @@ TEST_TEAR_DOWN( MqttTest )
 
 /*-----------------------------------------------------------*/
 
+#ifdef MQTT_TEST_REUSE_CONNECTION
+
+/**
+ * @brief Disconnect the session shared by the MQTT tests, if any.
+ */
+    static void releaseSharedSession( void )
+    {
+        if( sharedSessionConnected == true )
+        {
+            sharedSessionConnected = false;
+            disconnectTestSession();
+        }
+    }
+
+#endif /* ifdef MQTT_TEST_REUSE_CONNECTION */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test setup function for MQTT tests.
+ */
+TEST_SETUP( MqttTest )
+{
+    #ifdef MQTT_TEST_REUSE_CONNECTION
+        char message[ 64 ];
+        uint32_t startTimeMs = FRTest_GetTimeMs();
+        bool reused = ( sessionReusable == true ) && ( sharedSessionConnected == true );
+    #endif
+
+    #ifdef MQTT_TEST_TIME_WARP_FACTOR
+        timeWarpEnabled = true;
+    #endif
+
+    #ifdef MQTT_TEST_REUSE_CONNECTION
+        if( reused == true )
+        {
+            resetTestState();
+        }
+        else
+        {
+            releaseSharedSession();
+            connectTestSession();
+        }
+
+        ( void ) snprintf( message, sizeof( message ), "Test setup: %u ms, %s session.",
+                           ( unsigned int ) ( FRTest_GetTimeMs() - startTimeMs ),
+                           ( reused == true ) ? "reused" : "new" );
+        TEST_MESSAGE( message );
+    #else
+        connectTestSession();
+    #endif /* ifdef MQTT_TEST_REUSE_CONNECTION */
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test tear down function for MQTT tests.
+ */
+TEST_TEAR_DOWN( MqttTest )
+{
+    #ifdef MQTT_TEST_REUSE_CONNECTION
+        /* Keep the session of a passing test for the next test that can share
+         * it. */
+        if( ( sessionReusable == true ) && ( Unity.CurrentTestFailed == 0 ) )
+        {
+            sharedSessionConnected = true;
+        }
+        else
+        {
+            disconnectTestSession();
+        }
+    #else
+        disconnectTestSession();
+    #endif /* ifdef MQTT_TEST_REUSE_CONNECTION */
+
+    #ifdef MQTT_TEST_PACKET_TRACE
+        dumpPacketTrace();
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Tests Subscribe and Publish operations with the MQTT broken using QoS 0.
  * The test subscribes to a topic, and then publishes to the same topic. The
@@ -843,12 +1737,12 @@ TEST( MqttTest, MQTT_Subscribe_Publish_With_Qos_0 )
      * It will be set when a SUBACK is received. */
     TEST_ASSERT_FALSE( receivedSubAck );
 
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -872,12 +1766,12 @@ TEST( MqttTest, MQTT_Subscribe_Publish_With_Qos_0 )
      * the same message that we published (as we have subscribed to the same topic). */
     TEST_ASSERT_FALSE( receivedPubAck );
     
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -906,12 +1800,12 @@ TEST( MqttTest, MQTT_Subscribe_Publish_With_Qos_0 )
                            &context, TEST_MQTT_TOPIC, MQTTQoS0 ) );
 
     /* We expect an UNSUBACK from the broker for the unsubscribe operation. */
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -944,12 +1838,12 @@ TEST( MqttTest, MQTT_Subscribe_Publish_With_Qos_1 )
      * a SUBACK is received. */
     TEST_ASSERT_FALSE( receivedSubAck );
 
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -986,12 +1880,12 @@ TEST( MqttTest, MQTT_Subscribe_Publish_With_Qos_1 )
      * same message that we published (as we have subscribed to the same topic). */
     TEST_ASSERT_FALSE( receivedPubAck );
     
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -1030,12 +1924,12 @@ TEST( MqttTest, MQTT_Subscribe_Publish_With_Qos_1 )
                            &context, TEST_MQTT_TOPIC, MQTTQoS1 ) );
 
     /* Expect an UNSUBACK from the broker for the unsubscribe operation. */
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -1085,12 +1979,12 @@ TEST( MqttTest, MQTT_Connect_LWT )
                            &context, TEST_MQTT_LWT_TOPIC, MQTTQoS0 ) );
 
     /* Wait for the SUBACK response from the broker for the subscribe request. */
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -1115,12 +2009,12 @@ TEST( MqttTest, MQTT_Connect_LWT )
 
     /* Run the process loop to receive the LWT. Allow some more time for the
      * server to realize the connection is closed. */
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1158,12 +2052,12 @@ TEST( MqttTest, MQTT_Connect_LWT )
     /* We expect an UNSUBACK from the broker for the unsubscribe operation. */
     TEST_ASSERT_FALSE( receivedUnsubAck );
     
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -1198,13 +2092,13 @@ TEST( MqttTest, MQTT_ProcessLoop_KeepAlive )
 
     TEST_ASSERT_EQUAL( 0, context.pingReqSendTimeMs );
 
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
         /* Check whether it has been more than twice the keep alive timeout. */
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_KEEP_ALIVE_INTERVAL_SECONDS * 2000 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_KEEP_ALIVE_INTERVAL_SECONDS * 2000 ) ) )
         {
             /* Timeout after waiting for twice the keep alive interval. */
             break;
@@ -1261,12 +2155,12 @@ TEST( MqttTest, MQTT_Resend_Unacked_Publish_QoS1 )
      * to terminated network connection.
      * The abrupt network disconnection should cause the PUBLISH packet to be left
      * in an un-acknowledged state in the MQTT context. */
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1280,7 +2174,7 @@ TEST( MqttTest, MQTT_Resend_Unacked_Publish_QoS1 )
     TEST_ASSERT_NOT_EQUAL( MQTT_PACKET_ID_INVALID, context.outgoingPublishRecords[ 0 ].packetId );
 
     /* Reset the transport receive function in the context. */
-    context.transportInterface.recv = testParam.pTransport->recv;
+    context.transportInterface.recv = MQTT_TEST_TRANSPORT_RECV;
 
     /* We will re-establish an MQTT over TLS connection with the broker to restore
      * the persistent session. */
@@ -1307,12 +2201,12 @@ TEST( MqttTest, MQTT_Resend_Unacked_Publish_QoS1 )
     /* Complete the QoS 1 PUBLISH resend operation. */
     TEST_ASSERT_FALSE( receivedPubAck );
     
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1360,12 +2254,12 @@ TEST( MqttTest, MQTT_Restore_Session_Duplicate_Incoming_Publish_Qos1 )
                            &context, TEST_MQTT_TOPIC, MQTTQoS1 ) );
     TEST_ASSERT_FALSE( receivedSubAck );
     
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -1398,12 +2292,12 @@ TEST( MqttTest, MQTT_Restore_Session_Duplicate_Incoming_Publish_Qos1 )
      * an acknowledgement cannot be sent to the broker. */
     packetTypeForDisconnection = MQTT_PACKET_TYPE_PUBLISH;
     
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1428,12 +2322,12 @@ TEST( MqttTest, MQTT_Restore_Session_Duplicate_Incoming_Publish_Qos1 )
 
     /* Process the duplicate incoming QoS 1 PUBLISH that will be sent by the broker
      * to re-attempt the PUBLISH operation. */
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1468,12 +2362,12 @@ TEST( MqttTest, MQTT_Publish_With_Retain_Flag )
     /* Complete the QoS 1 PUBLISH operation. */
     TEST_ASSERT_FALSE( receivedPubAck );
 
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1501,12 +2395,12 @@ TEST( MqttTest, MQTT_Publish_With_Retain_Flag )
 
     TEST_ASSERT_FALSE( receivedRetainedMessage );
 
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1546,12 +2440,12 @@ TEST( MqttTest, MQTT_Publish_With_Retain_Flag )
 
     /* Complete the QoS 1 PUBLISH operation. */
     TEST_ASSERT_FALSE( receivedPubAck );
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1577,12 +2471,12 @@ TEST( MqttTest, MQTT_Publish_With_Retain_Flag )
                            &context, TEST_MQTT_TOPIC, MQTTQoS1 ) );
     TEST_ASSERT_FALSE( receivedSubAck );
 
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2 ) ) )
         {
             /* Timeout. */
             break;
@@ -1652,12 +2546,12 @@ TEST( MqttTest, MQTT_SubUnsub_Multiple_Topics )
 
     /* Expect a SUBACK from the broker for the subscribe operation. */
     TEST_ASSERT_FALSE( receivedSubAck );
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -1693,12 +2587,12 @@ TEST( MqttTest, MQTT_SubUnsub_Multiple_Topics )
         /* Reset the PUBACK flag. */
         receivedPubAck = false;
 
-        entryTime = FRTest_GetTimeMs();
+        entryTime = MQTT_TEST_GET_TIME_MS();
         do
         {
             xMQTTStatus = MQTT_ProcessLoop( &context );
 
-            if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+            if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
             {
                 /* Timeout. */
                 break;
@@ -1729,21 +2623,6 @@ TEST( MqttTest, MQTT_SubUnsub_Multiple_Topics )
         TEST_ASSERT_EQUAL_MEMORY( MQTT_EXAMPLE_MESSAGE,
                                   incomingInfo.pPayload,
                                   incomingInfo.payloadLength );
-
-        /* Free memory, if allocated during test case execution. */
-        if( incomingInfo.pTopicName != NULL )
-        {
-            free( ( void * ) incomingInfo.pTopicName );
-        }
-
-        if( incomingInfo.pPayload != NULL )
-        {
-            free( ( void * ) incomingInfo.pPayload );
-        }
-
-        /* Reset the pointers to NULL. */
-        incomingInfo.pTopicName = NULL;
-        incomingInfo.pPayload = NULL;
     }
 
     globalUnsubscribePacketIdentifier = MQTT_GetPacketId( &context );
@@ -1758,12 +2637,12 @@ TEST( MqttTest, MQTT_SubUnsub_Multiple_Topics )
     receivedUnsubAck = false;
 
     /* Expect an UNSUBACK from the broker for the unsubscribe operation. */
-    entryTime = FRTest_GetTimeMs();
+    entryTime = MQTT_TEST_GET_TIME_MS();
     do
     {
         xMQTTStatus = MQTT_ProcessLoop( &context );
 
-        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        if( MQTT_TEST_GET_TIME_MS() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
         {
             /* Timeout. */
             break;
@@ -1789,36 +2668,3634 @@ TEST( MqttTest, MQTT_SubUnsub_Multiple_Topics )
  */
 TEST_GROUP_RUNNER( MqttTest )
 {
-    RUN_TEST_CASE( MqttTest, MQTT_Subscribe_Publish_With_Qos_0 );
-    RUN_TEST_CASE( MqttTest, MQTT_Subscribe_Publish_With_Qos_1 );
-    RUN_TEST_CASE( MqttTest, MQTT_Connect_LWT );
-    RUN_TEST_CASE( MqttTest, MQTT_ProcessLoop_KeepAlive );
-    RUN_TEST_CASE( MqttTest, MQTT_Resend_Unacked_Publish_QoS1 );
-    RUN_TEST_CASE( MqttTest, MQTT_Restore_Session_Duplicate_Incoming_Publish_Qos1 );
-    RUN_TEST_CASE( MqttTest, MQTT_Publish_With_Retain_Flag );
-    RUN_TEST_CASE( MqttTest, MQTT_SubUnsub_Multiple_Topics );
+    #ifdef MQTT_TEST_REUSE_CONNECTION
+        /* Tests which only need an established clean session run first and
+         * share it. The other tests need a new session or change the session
+         * state. */
+        sessionReusable = true;
+        RUN_TEST_CASE( MqttTest, MQTT_Subscribe_Publish_With_Qos_0 );
+        RUN_TEST_CASE( MqttTest, MQTT_Subscribe_Publish_With_Qos_1 );
+        RUN_TEST_CASE( MqttTest, MQTT_SubUnsub_Multiple_Topics );
+        sessionReusable = false;
+        RUN_TEST_CASE( MqttTest, MQTT_Connect_LWT );
+        RUN_TEST_CASE( MqttTest, MQTT_ProcessLoop_KeepAlive );
+        RUN_TEST_CASE( MqttTest, MQTT_Resend_Unacked_Publish_QoS1 );
+        RUN_TEST_CASE( MqttTest, MQTT_Restore_Session_Duplicate_Incoming_Publish_Qos1 );
+        RUN_TEST_CASE( MqttTest, MQTT_Publish_With_Retain_Flag );
+        releaseSharedSession();
+    #else
+        RUN_TEST_CASE( MqttTest, MQTT_Subscribe_Publish_With_Qos_0 );
+        RUN_TEST_CASE( MqttTest, MQTT_Subscribe_Publish_With_Qos_1 );
+        RUN_TEST_CASE( MqttTest, MQTT_Connect_LWT );
+        RUN_TEST_CASE( MqttTest, MQTT_ProcessLoop_KeepAlive );
+        RUN_TEST_CASE( MqttTest, MQTT_Resend_Unacked_Publish_QoS1 );
+        RUN_TEST_CASE( MqttTest, MQTT_Restore_Session_Duplicate_Incoming_Publish_Qos1 );
+        RUN_TEST_CASE( MqttTest, MQTT_Publish_With_Retain_Flag );
+        RUN_TEST_CASE( MqttTest, MQTT_SubUnsub_Multiple_Topics );
+    #endif /* ifdef MQTT_TEST_REUSE_CONNECTION */
 }
 
 /*-----------------------------------------------------------*/
 
-int RunMqttTest( void )
+#ifdef MQTT_TEST_EXECUTE_BENCHMARK_TESTS
+
+/**
+ * @brief Test group for MQTT benchmarks.
+ */
+TEST_GROUP( MqttBenchmark );
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Payload of the benchmark publishes.
+ */
+static uint8_t benchmarkPayload[ MQTT_TEST_NETWORK_BUFFER_SIZE ];
+
+/**
+ * @brief State of the publish-to-receive latency benchmark.
+ */
+typedef struct LatencyBenchmark
 {
-    int status = -1;
+    uint32_t latencyUs[ MQTT_BENCHMARK_LATENCY_SAMPLES ]; /**< @brief Latency of each received message, in receive order. */
+    bool received[ MQTT_BENCHMARK_LATENCY_SAMPLES ];      /**< @brief Whether the message with a sequence number was received. */
+    uint32_t receivedCount;                               /**< @brief Number of distinct messages received. */
+    uint32_t highestSequence;                             /**< @brief Highest sequence number received plus one. */
+    uint32_t reorderedCount;                              /**< @brief Messages received after a message published later. */
+    uint32_t duplicateCount;                              /**< @brief Messages received more than once. */
+    uint32_t unexpectedCount;                             /**< @brief Messages that are not from the running benchmark. */
+} LatencyBenchmark_t;
 
-    /* Calls user-implemented SetupMqttTestParam to fill in testParam */
-    SetupMqttTestParam( &testParam );
-    testHostInfo.pHostName = MQTT_SERVER_ENDPOINT;
-    testHostInfo.port = MQTT_SERVER_PORT;
+/**
+ * @brief State of the running latency benchmark.
+ */
+static LatencyBenchmark_t latencyBenchmark;
 
-    /* Initialize unity. */
-    UnityFixture.Verbose = 1;
-    UnityFixture.GroupFilter = 0;
-    UnityFixture.NameFilter = 0;
-    UnityFixture.RepeatCount = 1;
+/**
+ * @brief Number of PUBACK or PUBCOMP packets received by the windowed publish
+ * benchmark.
+ */
+static uint32_t completedPublishCount = 0;
 
-    UNITY_BEGIN();
+/**
+ * @brief State of the QoS 2 handshake benchmark.
+ *
+ * The publishes in flight are tracked by packet identifier in slots that
+ * mirror the outgoing publish records of the MQTT context.
+ */
+typedef struct Qos2Benchmark
+{
+    uint16_t packetIds[ OUTGOING_PUBLISH_RECORD_COUNT ];       /**< @brief Packet identifier of the publish in each slot, 0 if the slot is free. */
+    uint32_t publishTimeUs[ OUTGOING_PUBLISH_RECORD_COUNT ];   /**< @brief Time the PUBLISH of each slot is sent. */
+    uint32_t pubRelTimeUs[ OUTGOING_PUBLISH_RECORD_COUNT ];    /**< @brief Time the PUBREC of each slot is received and the PUBREL sent. */
+    uint32_t pubRecLatencyUs[ MQTT_BENCHMARK_PUBLISH_COUNT ];  /**< @brief PUBLISH to PUBREC latency of each exchange. */
+    uint32_t pubCompLatencyUs[ MQTT_BENCHMARK_PUBLISH_COUNT ]; /**< @brief PUBREL to PUBCOMP latency of each exchange. */
+    uint32_t pubRecCount;                                      /**< @brief Number of PUBREC packets received. */
+    uint32_t pubCompCount;                                     /**< @brief Number of PUBCOMP packets received. */
+    uint32_t unexpectedCount;                                  /**< @brief Acknowledgements that do not match a publish in flight. */
+} Qos2Benchmark_t;
 
-    RUN_TEST_GROUP( MqttTest );
+/**
+ * @brief State of the running QoS 2 handshake benchmark.
+ */
+static Qos2Benchmark_t qos2Benchmark;
+
+/**
+ * @brief State of the subscription table benchmark.
+ */
+typedef struct SubscriptionBenchmark
+{
+    char topicFilters[ MQTT_BENCHMARK_TOPIC_FILTER_COUNT ][ MQTT_BENCHMARK_TOPIC_FILTER_SIZE ]; /**< @brief Topic filters subscribed to. */
+    MQTTSubscribeInfo_t subscriptions[ MQTT_BENCHMARK_TOPIC_FILTER_COUNT ];                    /**< @brief Subscriptions of the topic filters. */
+    size_t subscribedCount;                                                                    /**< @brief Number of topic filters subscribed to so far, searched by the dispatch. */
+    uint16_t subscribePacketId;                                                                /**< @brief Packet identifier of the pending SUBSCRIBE. */
+    bool subAckReceived;                                                                       /**< @brief Whether the SUBACK of the pending SUBSCRIBE is received. */
+    uint32_t rejectedCount;                                                                    /**< @brief Topic filters rejected in the SUBACKs. */
+    uint32_t dispatchedCount;                                                                  /**< @brief Incoming messages dispatched. */
+    uint32_t matchCount;                                                                       /**< @brief Topic filters matched by the dispatched messages. */
+    uint32_t dispatchTimeUs;                                                                   /**< @brief Time spent matching the incoming messages. */
+} SubscriptionBenchmark_t;
+
+/**
+ * @brief State of the running subscription table benchmark.
+ */
+static SubscriptionBenchmark_t subscriptionBenchmark;
+
+/**
+ * @brief Events of a network buffer sizing trial.
+ */
+    #define NETWORK_BUFFER_TRIAL_SUBACK     ( 0x01U ) /**< @brief The SUBACK is received. */
+    #define NETWORK_BUFFER_TRIAL_PUBACK     ( 0x02U ) /**< @brief The PUBACK of the publish is received. */
+    #define NETWORK_BUFFER_TRIAL_PUBLISH    ( 0x04U ) /**< @brief The publish is received back. */
+
+/**
+ * @brief State of a trial of the network buffer sizing benchmark.
+ */
+typedef struct NetworkBufferTrial
+{
+    size_t payloadLength;       /**< @brief Payload length of the message published and received back. */
+    uint16_t subscribePacketId; /**< @brief Packet identifier of the SUBSCRIBE. */
+    uint16_t publishPacketId;   /**< @brief Packet identifier of the PUBLISH. */
+    uint32_t events;            /**< @brief NETWORK_BUFFER_TRIAL_* events received. */
+} NetworkBufferTrial_t;
+
+/**
+ * @brief State of the running network buffer sizing trial.
+ */
+static NetworkBufferTrial_t networkBufferTrial;
+
+/**
+ * @brief Buffer of which the network buffer sizing benchmark passes a slice of
+ * the size under trial to MQTT_Init.
+ */
+static uint8_t networkBufferTrialBuffer[ MQTT_TEST_NETWORK_BUFFER_SIZE ];
+
+/**
+ * @brief Outgoing and incoming publish records of the network buffer sizing
+ * trials.
+ */
+static MQTTPubAckInfo_t networkBufferTrialOutgoingRecords[ OUTGOING_PUBLISH_RECORD_COUNT ];
+static MQTTPubAckInfo_t networkBufferTrialIncomingRecords[ INCOMING_PUBLISH_RECORD_COUNT ];
+
+/**
+ * @brief State of a client of the concurrent clients benchmark.
+ */
+typedef struct BenchmarkClient
+{
+    MQTTContext_t * pContext;                  /**< @brief MQTT context of the client. */
+    void * pNetworkContext;                    /**< @brief Network context of the client. */
+    char topic[ TEST_MQTT_TOPIC_LENGTH + 8U ]; /**< @brief Topic the client publishes to and subscribes to. */
+    uint16_t topicLength;                      /**< @brief Length of the topic. */
+    uint16_t subscribePacketId;                /**< @brief Packet identifier of the pending SUBSCRIBE. */
+    uint16_t publishPacketId;                  /**< @brief Packet identifier of the pending PUBLISH. */
+    bool subAckReceived;                       /**< @brief Whether the SUBACK is received. */
+    bool pubAckReceived;                       /**< @brief Whether the PUBACK of the pending PUBLISH is received. */
+    uint32_t publishedCount;                   /**< @brief Number of acknowledged publishes. */
+    uint32_t receivedCount;                    /**< @brief Number of messages received back. */
+    uint32_t startTimeMs;                      /**< @brief Time the client started publishing. */
+    uint32_t endTimeMs;                        /**< @brief Time the client received its last message. */
+    bool connected;                            /**< @brief Whether the client is connected by the benchmark. */
+    volatile bool stopFlag;                    /**< @brief Request the client thread to stop. */
+    bool result;                               /**< @brief Result of the client thread. */
+} BenchmarkClient_t;
+
+/**
+ * @brief Clients of the concurrent clients benchmark. The first client uses
+ * the network context of the test fixture.
+ */
+static BenchmarkClient_t benchmarkClients[ MQTT_BENCHMARK_CLIENT_COUNT ];
+
+/**
+ * @brief MQTT contexts of the benchmark clients.
+ */
+static MQTTContext_t benchmarkClientContexts[ MQTT_BENCHMARK_CLIENT_COUNT ];
+
+/**
+ * @brief Network buffers of the benchmark clients.
+ */
+static uint8_t benchmarkClientBuffers[ MQTT_BENCHMARK_CLIENT_COUNT ][ MQTT_TEST_NETWORK_BUFFER_SIZE ];
+
+/**
+ * @brief Outgoing publish records of the benchmark clients.
+ */
+static MQTTPubAckInfo_t benchmarkClientOutgoingRecords[ MQTT_BENCHMARK_CLIENT_COUNT ][ OUTGOING_PUBLISH_RECORD_COUNT ];
+
+/**
+ * @brief Incoming publish records of the benchmark clients.
+ */
+static MQTTPubAckInfo_t benchmarkClientIncomingRecords[ MQTT_BENCHMARK_CLIENT_COUNT ][ INCOMING_PUBLISH_RECORD_COUNT ];
+
+/**
+ * @brief State of the slow consumer benchmark, shared by the flooding thread
+ * and the test thread. The flood members are written by the flooding thread
+ * and polled by the test thread.
+ */
+typedef struct SlowConsumerBenchmark
+{
+    volatile uint32_t floodedCount; /**< @brief Number of messages sent by the flooding connection. */
+    volatile uint32_t floodStartMs; /**< @brief Time the flooding connection started sending. */
+    volatile uint32_t floodEndMs;   /**< @brief Time the flooding connection sent its last message. */
+    volatile bool floodDone;        /**< @brief Whether the flooding thread is done sending. */
+    volatile bool floodResult;      /**< @brief Whether every flooding publish succeeded. */
+    uint32_t consumedCount;         /**< @brief Number of messages processed by the slow consumer. */
+    uint32_t unexpectedCount;       /**< @brief Number of received messages of another size. */
+} SlowConsumerBenchmark_t;
+
+/**
+ * @brief State of the slow consumer benchmark.
+ */
+static SlowConsumerBenchmark_t slowConsumerBenchmark;
+
+/**
+ * @brief State of the Last Will and Testament delivery latency benchmark.
+ */
+typedef struct LwtBenchmark
+{
+    uint32_t sequence;       /**< @brief Sequence number in the payload of the expected will. */
+    uint32_t receivedTimeUs; /**< @brief Time the expected will is received. */
+    bool received;           /**< @brief Whether the expected will is received. */
+    uint32_t staleCount;     /**< @brief Number of wills of previous iterations received late. */
+} LwtBenchmark_t;
+
+/**
+ * @brief State of the Last Will and Testament delivery latency benchmark.
+ */
+static LwtBenchmark_t lwtBenchmark;
+
+/**
+ * @brief State of the retained message storm benchmark.
+ */
+typedef struct RetainedStorm
+{
+    bool received[ MQTT_BENCHMARK_RETAINED_COUNT ]; /**< @brief Whether each retained message is received. */
+    uint32_t receivedCount;                         /**< @brief Number of retained messages received. */
+    uint32_t duplicateCount;                        /**< @brief Number of retained messages received again. */
+    uint32_t unexpectedCount;                       /**< @brief Number of other retained messages received. */
+    uint32_t subAckTimeUs;                          /**< @brief Time the SUBACK is received. */
+    uint32_t lastMessageTimeUs;                     /**< @brief Time the last retained message is received. */
+    size_t peakBufferUsage;                         /**< @brief Largest number of bytes used in the network buffer. */
+    #ifdef MQTT_BENCHMARK_GET_FREE_HEAP_SIZE
+        size_t minFreeHeapSize;                     /**< @brief Smallest free heap size sampled. */
+    #endif
+} RetainedStorm_t;
+
+/**
+ * @brief State of the retained message storm benchmark.
+ */
+static RetainedStorm_t retainedStorm;
+
+#ifdef MQTT_BENCHMARK_BURST_TOPIC
+
+/**
+ * @brief State of a burst of the coalesced packet receive benchmark. The recv
+ * calls before the first byte of the burst arrives are not counted.
+ */
+typedef struct CoalescedReceive
+{
+    uint32_t recvCount;        /**< @brief Number of transport recv calls. */
+    uint32_t dataRecvCount;    /**< @brief Number of transport recv calls returning data. */
+    uint32_t recvBytes;        /**< @brief Number of bytes received. */
+    uint32_t maxRecvBytes;     /**< @brief Largest number of bytes returned by a recv call. */
+    uint32_t firstDataTimeUs;  /**< @brief Time the first byte of the burst is received. */
+    uint32_t lastPacketTimeUs; /**< @brief Time the last publish of the burst is handled. */
+    uint32_t receivedCount;    /**< @brief Number of publishes of the burst received. */
+    uint32_t unexpectedCount;  /**< @brief Number of other publishes received. */
+} CoalescedReceive_t;
+
+/**
+ * @brief State of the current burst of the coalesced packet receive benchmark.
+ */
+static CoalescedReceive_t coalescedReceive;
+
+#endif /* ifdef MQTT_BENCHMARK_BURST_TOPIC */
+
+#ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS
+
+/**
+ * @brief Lock statistics of a thread of the process loop thread benchmark.
+ */
+typedef struct BenchmarkLockStats
+{
+    uint32_t lockCount;      /**< @brief Number of times the mutex is acquired. */
+    uint32_t contendedCount; /**< @brief Number of times the mutex is held by another thread. */
+    uint32_t totalWaitUs;    /**< @brief Total time waiting for a contended mutex. */
+    uint32_t maxWaitUs;      /**< @brief Longest time waiting for a contended mutex. */
+} BenchmarkLockStats_t;
+
+/**
+ * @brief State of a publisher thread of the process loop thread benchmark.
+ */
+typedef struct PublisherThread
+{
+    uint8_t payload[ MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE ]; /**< @brief Payload of the messages of the thread. */
+    uint32_t publishedCount;                                 /**< @brief Number of messages published. */
+    uint32_t windowFullCount;                                /**< @brief Number of publishes retried without a free publish record. */
+    BenchmarkLockStats_t lockStats;                          /**< @brief Lock statistics of the thread. */
+    bool result;                                             /**< @brief Result of the thread. */
+} PublisherThread_t;
+
+/**
+ * @brief State of the process loop thread benchmark. The counters updated by
+ * the event callback are only read with the mutex held while the threads run.
+ */
+typedef struct ProcessLoopThreadBenchmark
+{
+    MQTTContext_t * pContext;                                              /**< @brief MQTT context shared by the threads. */
+    FRTestMutexHandle_t mutex;                                             /**< @brief Mutex serializing the calls on the MQTT context. */
+    PublisherThread_t publishers[ MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT ]; /**< @brief Publisher threads. */
+    uint32_t nextSequence[ MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT ];        /**< @brief Next sequence number expected from each publisher. */
+    BenchmarkLockStats_t lockStats;                                        /**< @brief Lock statistics of the process loop thread. */
+    uint32_t processLoopCount;                                             /**< @brief Number of MQTT_ProcessLoop calls. */
+    MQTTStatus_t processLoopStatus;                                        /**< @brief Status of the last MQTT_ProcessLoop call. */
+    uint32_t pubAckCount;                                                  /**< @brief Number of PUBACKs received. */
+    uint32_t receivedCount;                                                /**< @brief Number of messages received back. */
+    uint32_t outOfOrderCount;                                              /**< @brief Number of messages received out of the order of their publisher. */
+    uint32_t corruptedCount;                                               /**< @brief Number of messages received with an unexpected payload. */
+    bool subAckReceived;                                                   /**< @brief Whether the SUBACK is received. */
+    volatile bool stopFlag;                                                /**< @brief Request the threads to stop. */
+} ProcessLoopThreadBenchmark_t;
+
+/**
+ * @brief State of the process loop thread benchmark.
+ */
+static ProcessLoopThreadBenchmark_t processLoopThreadBenchmark;
+
+#endif /* ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Format a benchmark result and print it with the Unity output.
+ */
+static void printBenchmarkResult( const char * pFormat,
+                                  ... )
+{
+    char message[ MQTT_BENCHMARK_MESSAGE_LENGTH ];
+    va_list args;
+
+    va_start( args, pFormat );
+    ( void ) vsnprintf( message, sizeof( message ), pFormat, args );
+    va_end( args );
+
+    TEST_MESSAGE( message );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of events per second, given the time they took in units of
+ * 1 / unitsPerSecond seconds. A time of 0 measured with a coarse timer is
+ * counted as one unit.
+ */
+static uint64_t getBenchmarkRate( uint64_t count,
+                                  uint32_t elapsed,
+                                  uint32_t unitsPerSecond )
+{
+    return ( count * unitsPerSecond ) / ( ( elapsed == 0U ) ? 1U : elapsed );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Percentile of count latencies sorted with compareLatency.
+ */
+static uint32_t getLatencyPercentile( const uint32_t * pSortedLatencies,
+                                      size_t count,
+                                      uint32_t percentile )
+{
+    return pSortedLatencies[ ( ( count - 1U ) * percentile ) / 100U ];
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish the first payloadLength bytes of benchmarkPayload.
+ */
+static MQTTStatus_t publishBenchmarkMessage( MQTTContext_t * pContext,
+                                             const char * pTopic,
+                                             MQTTQoS_t qos,
+                                             size_t payloadLength,
+                                             uint16_t packetId )
+{
+    MQTTPublishInfo_t publishInfo;
+
+    assert( pContext != NULL );
+
+    ( void ) memset( &publishInfo, 0x00, sizeof( publishInfo ) );
+    publishInfo.qos = qos;
+    publishInfo.pTopicName = pTopic;
+    publishInfo.topicNameLength = strlen( pTopic );
+    publishInfo.pPayload = benchmarkPayload;
+    publishInfo.payloadLength = payloadLength;
+
+    globalPublishPacketIdentifier = packetId;
+
+    return MQTT_Publish( pContext, &publishInfo, packetId );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Call MQTT_ProcessLoop until the PUBACK of a QoS 1 publish or the
+ * PUBCOMP of a QoS 2 publish is received.
+ *
+ * @return true if the acknowledgement is received within
+ * MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS, false otherwise.
+ */
+static bool waitForPublishAck( MQTTContext_t * pContext,
+                               MQTTQoS_t qos )
+{
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+    uint32_t entryTime;
+    const bool * pAckReceived = ( qos == MQTTQoS1 ) ? &receivedPubAck : &receivedPubComp;
+
+    entryTime = FRTest_GetTimeMs();
+
+    while( ( *pAckReceived == false ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) )
+    {
+        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        {
+            /* Timeout. */
+            break;
+        }
+
+        xMQTTStatus = MQTT_ProcessLoop( pContext );
+    }
+
+    return *pAckReceived;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback recording the latency of the incoming
+ * latency benchmark messages.
+ */
+static void latencyEventCallback( MQTTContext_t * pContext,
+                                  MQTTPacketInfo_t * pPacketInfo,
+                                  MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    const MQTTPublishInfo_t * pPublishInfo = pDeserializedInfo->pPublishInfo;
+    uint32_t receiveTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+    uint32_t sequence;
+    uint32_t sendTimeUs;
+
+    ( void ) pContext;
+
+    /* Acknowledgements of the benchmark publishes are handled by the library. */
+    if( ( pPacketInfo->type & 0xF0U ) != MQTT_PACKET_TYPE_PUBLISH )
+    {
+        return;
+    }
+
+    if( pPublishInfo->payloadLength != MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE )
+    {
+        latencyBenchmark.unexpectedCount++;
+        return;
+    }
+
+    ( void ) memcpy( &sequence, pPublishInfo->pPayload, sizeof( sequence ) );
+    ( void ) memcpy( &sendTimeUs, ( const uint8_t * ) pPublishInfo->pPayload + sizeof( sequence ), sizeof( sendTimeUs ) );
+
+    if( sequence >= MQTT_BENCHMARK_LATENCY_SAMPLES )
+    {
+        latencyBenchmark.unexpectedCount++;
+    }
+    else if( latencyBenchmark.received[ sequence ] == true )
+    {
+        latencyBenchmark.duplicateCount++;
+    }
+    else
+    {
+        latencyBenchmark.received[ sequence ] = true;
+        latencyBenchmark.latencyUs[ latencyBenchmark.receivedCount ] = receiveTimeUs - sendTimeUs;
+        latencyBenchmark.receivedCount++;
+
+        if( sequence < latencyBenchmark.highestSequence )
+        {
+            latencyBenchmark.reorderedCount++;
+        }
+        else
+        {
+            latencyBenchmark.highestSequence = sequence + 1U;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback counting the publishes completed by a
+ * PUBACK or a PUBCOMP.
+ */
+static void windowEventCallback( MQTTContext_t * pContext,
+                                 MQTTPacketInfo_t * pPacketInfo,
+                                 MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+    ( void ) pDeserializedInfo;
+
+    if( ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK ) ||
+        ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBCOMP ) )
+    {
+        completedPublishCount++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback timing the phases of the QoS 2 handshakes.
+ *
+ * The library sends the PUBREL once the PUBREC is handled, so the time the
+ * PUBREC is received starts the PUBREL to PUBCOMP phase.
+ */
+static void qos2EventCallback( MQTTContext_t * pContext,
+                               MQTTPacketInfo_t * pPacketInfo,
+                               MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    uint32_t receiveTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+    size_t slot;
+
+    ( void ) pContext;
+
+    if( ( pPacketInfo->type != MQTT_PACKET_TYPE_PUBREC ) &&
+        ( pPacketInfo->type != MQTT_PACKET_TYPE_PUBCOMP ) )
+    {
+        return;
+    }
+
+    for( slot = 0; slot < OUTGOING_PUBLISH_RECORD_COUNT; slot++ )
+    {
+        if( qos2Benchmark.packetIds[ slot ] == pDeserializedInfo->packetIdentifier )
+        {
+            break;
+        }
+    }
+
+    /* A PUBREC beyond the publish count can only be a duplicate. */
+    if( ( slot == OUTGOING_PUBLISH_RECORD_COUNT ) || ( pDeserializedInfo->packetIdentifier == 0U ) ||
+        ( ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBREC ) && ( qos2Benchmark.pubRecCount >= MQTT_BENCHMARK_PUBLISH_COUNT ) ) )
+    {
+        qos2Benchmark.unexpectedCount++;
+    }
+    else if( pPacketInfo->type == MQTT_PACKET_TYPE_PUBREC )
+    {
+        qos2Benchmark.pubRecLatencyUs[ qos2Benchmark.pubRecCount ] = receiveTimeUs - qos2Benchmark.publishTimeUs[ slot ];
+        qos2Benchmark.pubRelTimeUs[ slot ] = receiveTimeUs;
+        qos2Benchmark.pubRecCount++;
+    }
+    else
+    {
+        qos2Benchmark.pubCompLatencyUs[ qos2Benchmark.pubCompCount ] = receiveTimeUs - qos2Benchmark.pubRelTimeUs[ slot ];
+        qos2Benchmark.pubCompCount++;
+        qos2Benchmark.packetIds[ slot ] = 0U;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback of the subscription table benchmark.
+ *
+ * SUBACK return codes are checked for rejected topic filters. Incoming
+ * messages are dispatched the way an application would, by matching their
+ * topic against every subscribed topic filter with MQTT_MatchTopic.
+ */
+static void subscriptionEventCallback( MQTTContext_t * pContext,
+                                       MQTTPacketInfo_t * pPacketInfo,
+                                       MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    const MQTTPublishInfo_t * pPublishInfo = pDeserializedInfo->pPublishInfo;
+    uint32_t startTimeUs;
+    bool isMatch;
+    size_t i;
+
+    ( void ) pContext;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        startTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+
+        for( i = 0; i < subscriptionBenchmark.subscribedCount; i++ )
+        {
+            isMatch = false;
+
+            if( ( MQTT_MatchTopic( pPublishInfo->pTopicName,
+                                   pPublishInfo->topicNameLength,
+                                   subscriptionBenchmark.subscriptions[ i ].pTopicFilter,
+                                   subscriptionBenchmark.subscriptions[ i ].topicFilterLength,
+                                   &isMatch ) == MQTTSuccess ) && ( isMatch == true ) )
+            {
+                subscriptionBenchmark.matchCount++;
+            }
+        }
+
+        subscriptionBenchmark.dispatchTimeUs += MQTT_BENCHMARK_GET_TIME_US() - startTimeUs;
+        subscriptionBenchmark.dispatchedCount++;
+    }
+    else if( ( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK ) &&
+             ( pDeserializedInfo->packetIdentifier == subscriptionBenchmark.subscribePacketId ) )
+    {
+        /* The return codes follow the 2 bytes packet identifier. */
+        for( i = 2U; i < pPacketInfo->remainingLength; i++ )
+        {
+            if( pPacketInfo->pRemainingData[ i ] == 0x80U )
+            {
+                subscriptionBenchmark.rejectedCount++;
+            }
+        }
+
+        subscriptionBenchmark.subAckReceived = true;
+    }
+    else
+    {
+        /* Nothing to do. */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Event callback of the concurrent clients benchmark. Each client only
+ * updates its own state.
+ */
+static void benchmarkClientEventCallback( MQTTContext_t * pContext,
+                                          MQTTPacketInfo_t * pPacketInfo,
+                                          MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    BenchmarkClient_t * pClient = NULL;
+    size_t i;
+
+    for( i = 0; i < MQTT_BENCHMARK_CLIENT_COUNT; i++ )
+    {
+        if( benchmarkClients[ i ].pContext == pContext )
+        {
+            pClient = &benchmarkClients[ i ];
+            break;
+        }
+    }
+
+    if( pClient == NULL )
+    {
+        /* Not a benchmark client. */
+    }
+    else if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        pClient->receivedCount++;
+    }
+    else if( ( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK ) &&
+             ( pDeserializedInfo->packetIdentifier == pClient->subscribePacketId ) )
+    {
+        pClient->subAckReceived = true;
+    }
+    else if( ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK ) &&
+             ( pDeserializedInfo->packetIdentifier == pClient->publishPacketId ) )
+    {
+        pClient->pubAckReceived = true;
+    }
+    else
+    {
+        /* Nothing to do. */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connect a benchmark client with its own MQTT context, network buffer
+ * and publish records, and the event callback of the benchmark. The client
+ * has no Last Will and Testament when pWillInfo is NULL.
+ */
+static void connectBenchmarkClient( size_t clientIndex,
+                                    MQTTEventCallback_t benchmarkClientCallback,
+                                    const MQTTPublishInfo_t * pWillInfo )
+{
+    BenchmarkClient_t * pClient = &benchmarkClients[ clientIndex ];
+    MQTTConnectInfo_t connectInfo = { 0 };
+    TransportInterface_t transport;
+    MQTTFixedBuffer_t networkBuffer;
+    bool sessionPresent = false;
+    char clientIdBuffer[ TEST_CLIENT_IDENTIFIER_LENGTH + MAX_RAND_NUMBER_DIGITS_FOR_CLIENT_ID + 8U ] = { 0 };
+
+    networkBuffer.pBuffer = benchmarkClientBuffers[ clientIndex ];
+    networkBuffer.size = MQTT_TEST_NETWORK_BUFFER_SIZE;
+
+    transport.pNetworkContext = pClient->pNetworkContext;
+    transport.send = MQTT_TEST_TRANSPORT_SEND;
+    transport.recv = MQTT_TEST_TRANSPORT_RECV;
+    transport.writev = MQTT_TEST_TRANSPORT_WRITEV;
+
+    #ifdef MQTT_TEST_PACKET_TRACE
+        /* Parse the new connection from the first packet. */
+        memset( &packetTraceStreams[ getPacketTraceFlags( pClient->pNetworkContext, false ) ], 0x00, sizeof( PacketTraceStream_t ) );
+        memset( &packetTraceStreams[ getPacketTraceFlags( pClient->pNetworkContext, true ) ], 0x00, sizeof( PacketTraceStream_t ) );
+    #endif
+
+    pClient->pContext = &benchmarkClientContexts[ clientIndex ];
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_Init( pClient->pContext,
+                                               &transport,
+                                               testParam.pGetTimeMs,
+                                               benchmarkClientCallback,
+                                               &networkBuffer ) );
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_InitStatefulQoS( pClient->pContext,
+                                                          benchmarkClientOutgoingRecords[ clientIndex ],
+                                                          OUTGOING_PUBLISH_RECORD_COUNT,
+                                                          benchmarkClientIncomingRecords[ clientIndex ],
+                                                          INCOMING_PUBLISH_RECORD_COUNT ) );
+
+    TEST_ASSERT_EQUAL( NETWORK_CONNECT_SUCCESS, ( *testParam.pNetworkConnect )( pClient->pNetworkContext,
+                                                                                &testHostInfo,
+                                                                                testParam.pNetworkCredentials ) );
+    pClient->connected = true;
+
+    /* The client identifiers differ from the one of the test fixture by the
+     * client index suffix. */
+    connectInfo.cleanSession = true;
+    connectInfo.clientIdentifierLength =
+        snprintf( clientIdBuffer,
+                  sizeof( clientIdBuffer ),
+                  "%d%s-%u", clientIdRandNumber,
+                  MQTT_TEST_CLIENT_IDENTIFIER,
+                  ( unsigned int ) clientIndex );
+    connectInfo.pClientIdentifier = clientIdBuffer;
+    connectInfo.keepAliveSeconds = MQTT_KEEP_ALIVE_INTERVAL_SECONDS;
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_Connect( pClient->pContext,
+                                                  &connectInfo,
+                                                  pWillInfo,
+                                                  CONNACK_RECV_TIMEOUT_MS,
+                                                  &sessionPresent ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Disconnect the benchmark clients connected by a benchmark.
+ */
+static void disconnectBenchmarkClients( void )
+{
+    size_t i;
+
+    for( i = 0; i < MQTT_BENCHMARK_CLIENT_COUNT; i++ )
+    {
+        if( benchmarkClients[ i ].connected == true )
+        {
+            ( void ) MQTT_Disconnect( benchmarkClients[ i ].pContext );
+            ( *testParam.pNetworkDisconnect )( benchmarkClients[ i ].pNetworkContext );
+            benchmarkClients[ i ].connected = false;
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Call MQTT_ProcessLoop of a benchmark client until a flag is set or
+ * MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS expires.
+ *
+ * @return true if the flag is set.
+ */
+static bool processBenchmarkClient( BenchmarkClient_t * pClient,
+                                    const bool * pFlag )
+{
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+    uint32_t entryTime = FRTest_GetTimeMs();
+
+    while( ( *pFlag == false ) && ( pClient->stopFlag == false ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+           ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+    {
+        xMQTTStatus = MQTT_ProcessLoop( pClient->pContext );
+    }
+
+    return *pFlag;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Thread function of a concurrent benchmark client. The client
+ * subscribes to its own topic, then publishes MQTT_BENCHMARK_PUBLISH_COUNT
+ * QoS 1 messages to it and receives them back.
+ *
+ * The thread reports failures in the result of the client as test assertions
+ * can only be used in the test thread.
+ */
+static void benchmarkClientThread( void * pParam )
+{
+    BenchmarkClient_t * pClient = pParam;
+    MQTTSubscribeInfo_t subscription = { 0 };
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t xMQTTStatus;
+    uint32_t entryTime;
+    bool receivedAll = false;
+
+    subscription.qos = MQTTQoS1;
+    subscription.pTopicFilter = pClient->topic;
+    subscription.topicFilterLength = pClient->topicLength;
+    pClient->subscribePacketId = MQTT_GetPacketId( pClient->pContext );
+
+    pClient->result = ( MQTT_Subscribe( pClient->pContext,
+                                        &subscription,
+                                        1,
+                                        pClient->subscribePacketId ) == MQTTSuccess );
+
+    if( pClient->result == true )
+    {
+        pClient->result = processBenchmarkClient( pClient, &pClient->subAckReceived );
+    }
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = pClient->topic;
+    publishInfo.topicNameLength = pClient->topicLength;
+    publishInfo.pPayload = benchmarkPayload;
+    publishInfo.payloadLength = MQTT_BENCHMARK_CLIENT_PAYLOAD_SIZE;
+
+    pClient->startTimeMs = FRTest_GetTimeMs();
+
+    while( ( pClient->result == true ) && ( pClient->publishedCount < MQTT_BENCHMARK_PUBLISH_COUNT ) )
+    {
+        pClient->pubAckReceived = false;
+        pClient->publishPacketId = MQTT_GetPacketId( pClient->pContext );
+
+        pClient->result = ( MQTT_Publish( pClient->pContext,
+                                          &publishInfo,
+                                          pClient->publishPacketId ) == MQTTSuccess );
+
+        if( pClient->result == true )
+        {
+            pClient->result = processBenchmarkClient( pClient, &pClient->pubAckReceived );
+            pClient->publishedCount++;
+        }
+    }
+
+    /* Receive the remaining messages sent back by the broker. */
+    entryTime = FRTest_GetTimeMs();
+    xMQTTStatus = MQTTSuccess;
+
+    while( ( pClient->result == true ) && ( receivedAll == false ) && ( pClient->stopFlag == false ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+           ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+    {
+        xMQTTStatus = MQTT_ProcessLoop( pClient->pContext );
+        receivedAll = ( pClient->receivedCount >= MQTT_BENCHMARK_PUBLISH_COUNT );
+    }
+
+    pClient->endTimeMs = FRTest_GetTimeMs();
+    pClient->result = ( pClient->result == true ) && ( pClient->receivedCount >= MQTT_BENCHMARK_PUBLISH_COUNT );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Request every thread of the concurrent clients benchmark to stop.
+ */
+static void stopBenchmarkClients( void )
+{
+    size_t i;
+
+    for( i = 0; i < MQTT_BENCHMARK_CLIENT_COUNT; i++ )
+    {
+        benchmarkClients[ i ].stopFlag = true;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Wait for the threads of the concurrent clients benchmark to exit.
+ *
+ * Every client is stopped when the threads are not all created or a thread
+ * runs over MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS, then the remaining threads
+ * are waited for, so that the test can fail without a thread still using a
+ * client context.
+ *
+ * @return true if all the threads are created and exit within
+ * MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS.
+ */
+static bool joinBenchmarkClientThreads( FRTestThreadHandle_t * pThreadHandles,
+                                        size_t threadCount )
+{
+    bool result = true;
+    size_t i;
+
+    if( threadCount < MQTT_BENCHMARK_CLIENT_COUNT )
+    {
+        stopBenchmarkClients();
+        result = false;
+    }
+
+    for( i = 0; i < threadCount; i++ )
+    {
+        if( FRTest_ThreadTimedJoin( pThreadHandles[ i ], MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS ) != 0 )
+        {
+            /* Stop the clients and wait for the thread again. */
+            stopBenchmarkClients();
+            result = false;
+            ( void ) FRTest_ThreadTimedJoin( pThreadHandles[ i ], MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS );
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback recording the events of a network buffer
+ * sizing trial.
+ */
+static void networkBufferTrialEventCallback( MQTTContext_t * pContext,
+                                             MQTTPacketInfo_t * pPacketInfo,
+                                             MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+
+    if( ( pPacketInfo->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        if( pDeserializedInfo->pPublishInfo->payloadLength == networkBufferTrial.payloadLength )
+        {
+            networkBufferTrial.events |= NETWORK_BUFFER_TRIAL_PUBLISH;
+        }
+    }
+    else if( ( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK ) &&
+             ( pDeserializedInfo->packetIdentifier == networkBufferTrial.subscribePacketId ) )
+    {
+        /* The return code follows the 2 bytes packet identifier. */
+        if( ( pPacketInfo->remainingLength > 2U ) && ( pPacketInfo->pRemainingData[ 2 ] != 0x80U ) )
+        {
+            networkBufferTrial.events |= NETWORK_BUFFER_TRIAL_SUBACK;
+        }
+    }
+    else if( ( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK ) &&
+             ( pDeserializedInfo->packetIdentifier == networkBufferTrial.publishPacketId ) )
+    {
+        networkBufferTrial.events |= NETWORK_BUFFER_TRIAL_PUBACK;
+    }
+    else
+    {
+        /* Other packets are handled by the library. */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Call MQTT_ProcessLoop until a network buffer sizing trial receives
+ * the expected events, MQTT_ProcessLoop fails or
+ * MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS expires.
+ */
+static bool waitForNetworkBufferTrial( uint32_t expectedEvents )
+{
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+    uint32_t entryTime = FRTest_GetTimeMs();
+
+    while( ( ( networkBufferTrial.events & expectedEvents ) != expectedEvents ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+           ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+    {
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+    }
+
+    return ( networkBufferTrial.events & expectedEvents ) == expectedEvents;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run the network buffer sizing workload with a network buffer of
+ * bufferSize bytes.
+ *
+ * The test context connects with the first bufferSize bytes of
+ * networkBufferTrialBuffer, subscribes to TEST_MQTT_TOPIC, publishes a QoS 1
+ * message of payloadLength bytes and receives it back, then disconnects. The
+ * library errors are not asserted, as they are the expected outcome of a too
+ * small buffer.
+ *
+ * @return true if the workload completed, false otherwise.
+ */
+static bool runNetworkBufferTrial( size_t bufferSize,
+                                   size_t payloadLength )
+{
+    MQTTConnectInfo_t connectInfo = { 0 };
+    MQTTSubscribeInfo_t subscribeInfo = { 0 };
+    TransportInterface_t transport;
+    MQTTFixedBuffer_t networkBuffer;
+    MQTTStatus_t xMQTTStatus;
+    bool sessionPresent = false;
+    bool result = false;
+    char clientIdBuffer[ TEST_CLIENT_IDENTIFIER_LENGTH + MAX_RAND_NUMBER_DIGITS_FOR_CLIENT_ID + 1U ] = { 0 };
+
+    networkBuffer.pBuffer = networkBufferTrialBuffer;
+    networkBuffer.size = bufferSize;
+
+    transport.pNetworkContext = testParam.pNetworkContext;
+    transport.send = MQTT_TEST_TRANSPORT_SEND;
+    transport.recv = MQTT_TEST_TRANSPORT_RECV;
+    transport.writev = MQTT_TEST_TRANSPORT_WRITEV;
+
+    ( void ) memset( &networkBufferTrial, 0x00, sizeof( networkBufferTrial ) );
+    networkBufferTrial.payloadLength = payloadLength;
+
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_Init( &context,
+                                               &transport,
+                                               testParam.pGetTimeMs,
+                                               eventCallback,
+                                               &networkBuffer ) );
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_InitStatefulQoS( &context,
+                                                          networkBufferTrialOutgoingRecords,
+                                                          OUTGOING_PUBLISH_RECORD_COUNT,
+                                                          networkBufferTrialIncomingRecords,
+                                                          INCOMING_PUBLISH_RECORD_COUNT ) );
+    TEST_ASSERT_EQUAL( NETWORK_CONNECT_SUCCESS, ( *testParam.pNetworkConnect )( testParam.pNetworkContext,
+                                                                                &testHostInfo,
+                                                                                testParam.pNetworkCredentials ) );
+
+    connectInfo.cleanSession = true;
+    connectInfo.clientIdentifierLength =
+        snprintf( clientIdBuffer,
+                  sizeof( clientIdBuffer ),
+                  "%d%s", clientIdRandNumber,
+                  MQTT_TEST_CLIENT_IDENTIFIER );
+    connectInfo.pClientIdentifier = clientIdBuffer;
+    connectInfo.keepAliveSeconds = MQTT_KEEP_ALIVE_INTERVAL_SECONDS;
+
+    xMQTTStatus = MQTT_Connect( &context, &connectInfo, NULL, CONNACK_RECV_TIMEOUT_MS, &sessionPresent );
+
+    if( xMQTTStatus == MQTTSuccess )
+    {
+        subscribeInfo.qos = MQTTQoS1;
+        subscribeInfo.pTopicFilter = TEST_MQTT_TOPIC;
+        subscribeInfo.topicFilterLength = TEST_MQTT_TOPIC_LENGTH;
+        networkBufferTrial.subscribePacketId = MQTT_GetPacketId( &context );
+
+        xMQTTStatus = MQTT_Subscribe( &context, &subscribeInfo, 1, networkBufferTrial.subscribePacketId );
+    }
+
+    if( ( xMQTTStatus == MQTTSuccess ) && ( waitForNetworkBufferTrial( NETWORK_BUFFER_TRIAL_SUBACK ) == true ) )
+    {
+        networkBufferTrial.publishPacketId = MQTT_GetPacketId( &context );
+        xMQTTStatus = publishBenchmarkMessage( &context, TEST_MQTT_TOPIC, MQTTQoS1, payloadLength,
+                                               networkBufferTrial.publishPacketId );
+
+        result = ( xMQTTStatus == MQTTSuccess ) &&
+                 ( waitForNetworkBufferTrial( NETWORK_BUFFER_TRIAL_SUBACK |
+                                              NETWORK_BUFFER_TRIAL_PUBACK |
+                                              NETWORK_BUFFER_TRIAL_PUBLISH ) == true );
+    }
+
+    ( void ) MQTT_Disconnect( &context );
+    ( *testParam.pNetworkDisconnect )( testParam.pNetworkContext );
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback of the slow consumer. Every message costs
+ * MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS of processing time before it counts as
+ * consumed.
+ */
+static void slowConsumerEventCallback( MQTTContext_t * pContext,
+                                       MQTTPacketInfo_t * pPacketInfo,
+                                       MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    ( void ) pContext;
+
+    /* PINGRESP packets are handled by the library. */
+    if( ( pPacketInfo->type & 0xF0U ) != MQTT_PACKET_TYPE_PUBLISH )
+    {
+        return;
+    }
+
+    if( pDeserializedInfo->pPublishInfo->payloadLength != MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE )
+    {
+        slowConsumerBenchmark.unexpectedCount++;
+    }
+    else
+    {
+        FRTest_TimeDelay( MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS );
+        slowConsumerBenchmark.consumedCount++;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Thread function of the flooding connection of the slow consumer
+ * benchmark. The client publishes MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT QoS 0
+ * messages to TEST_MQTT_TOPIC as fast as the transport accepts them.
+ */
+static void floodThread( void * pParam )
+{
+    BenchmarkClient_t * pClient = pParam;
+    MQTTPublishInfo_t publishInfo = { 0 };
+
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = TEST_MQTT_TOPIC;
+    publishInfo.topicNameLength = TEST_MQTT_TOPIC_LENGTH;
+    publishInfo.pPayload = benchmarkPayload;
+    publishInfo.payloadLength = MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE;
+
+    slowConsumerBenchmark.floodResult = true;
+    slowConsumerBenchmark.floodStartMs = FRTest_GetTimeMs();
+
+    while( ( slowConsumerBenchmark.floodResult == true ) && ( pClient->stopFlag == false ) &&
+           ( slowConsumerBenchmark.floodedCount < MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT ) )
+    {
+        slowConsumerBenchmark.floodResult = ( MQTT_Publish( pClient->pContext, &publishInfo, 0U ) == MQTTSuccess );
+
+        if( slowConsumerBenchmark.floodResult == true )
+        {
+            slowConsumerBenchmark.floodedCount++;
+        }
+    }
+
+    slowConsumerBenchmark.floodEndMs = FRTest_GetTimeMs();
+    slowConsumerBenchmark.floodDone = true;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback recording the time the will of the current
+ * iteration of the Last Will and Testament delivery latency benchmark is
+ * received.
+ */
+static void lwtEventCallback( MQTTContext_t * pContext,
+                              MQTTPacketInfo_t * pPacketInfo,
+                              MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    const MQTTPublishInfo_t * pPublishInfo = pDeserializedInfo->pPublishInfo;
+    uint32_t receivedTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+    uint32_t sequence;
+
+    ( void ) pContext;
+
+    if( ( ( pPacketInfo->type & 0xF0U ) != MQTT_PACKET_TYPE_PUBLISH ) ||
+        ( pPublishInfo->topicNameLength != TEST_MQTT_LWT_TOPIC_LENGTH ) ||
+        ( memcmp( pPublishInfo->pTopicName, TEST_MQTT_LWT_TOPIC, TEST_MQTT_LWT_TOPIC_LENGTH ) != 0 ) ||
+        ( pPublishInfo->payloadLength != sizeof( sequence ) ) )
+    {
+        return;
+    }
+
+    ( void ) memcpy( &sequence, pPublishInfo->pPayload, sizeof( sequence ) );
+
+    if( sequence == lwtBenchmark.sequence )
+    {
+        lwtBenchmark.receivedTimeUs = receivedTimeUs;
+        lwtBenchmark.received = true;
+    }
+    else
+    {
+        lwtBenchmark.staleCount++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sample the free heap size of the platform, if
+ * MQTT_BENCHMARK_GET_FREE_HEAP_SIZE is defined, for the retained message storm
+ * benchmark.
+ */
+static void sampleRetainedStormHeap( void )
+{
+    #ifdef MQTT_BENCHMARK_GET_FREE_HEAP_SIZE
+        size_t freeHeapSize = MQTT_BENCHMARK_GET_FREE_HEAP_SIZE();
+
+        if( freeHeapSize < retainedStorm.minFreeHeapSize )
+        {
+            retainedStorm.minFreeHeapSize = freeHeapSize;
+        }
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Transport recv function of the retained message storm benchmark,
+ * recording the largest number of bytes used in the network buffer of the
+ * test context.
+ */
+static int32_t retainedStormRecv( NetworkContext_t * pNetworkContext,
+                                  void * pBuffer,
+                                  size_t bytesToRecv )
+{
+    int32_t result = MQTT_TEST_TRANSPORT_RECV( pNetworkContext, pBuffer, bytesToRecv );
+    const uint8_t * pNetworkBuffer = context.networkBuffer.pBuffer;
+    size_t bufferUsage;
+
+    if( ( result > 0 ) &&
+        ( ( const uint8_t * ) pBuffer >= pNetworkBuffer ) &&
+        ( ( const uint8_t * ) pBuffer < ( pNetworkBuffer + context.networkBuffer.size ) ) )
+    {
+        bufferUsage = ( size_t ) ( ( const uint8_t * ) pBuffer - pNetworkBuffer ) + ( size_t ) result;
+
+        if( bufferUsage > retainedStorm.peakBufferUsage )
+        {
+            retainedStorm.peakBufferUsage = bufferUsage;
+        }
+    }
+
+    sampleRetainedStormHeap();
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback of the retained message storm benchmark.
+ * The retained messages are counted by the index at the end of their topic,
+ * the other packets are handled as in the MQTT tests.
+ */
+static void retainedStormEventCallback( MQTTContext_t * pContext,
+                                        MQTTPacketInfo_t * pPacketInfo,
+                                        MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    const MQTTPublishInfo_t * pPublishInfo = pDeserializedInfo->pPublishInfo;
+    uint32_t index = 0U;
+    size_t i;
+    bool validTopic;
+
+    ( void ) pContext;
+
+    if( ( pPacketInfo->type & 0xF0U ) != MQTT_PACKET_TYPE_PUBLISH )
+    {
+        if( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK )
+        {
+            retainedStorm.subAckTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+        }
+
+        handleAckEvents( pPacketInfo, pDeserializedInfo->packetIdentifier );
+        return;
+    }
+
+    /* The messages clearing the retained messages are forwarded without the
+     * retain flag. */
+    if( pPublishInfo->retain == false )
+    {
+        return;
+    }
+
+    validTopic = ( pPublishInfo->topicNameLength > MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX_LENGTH ) &&
+                 ( pPublishInfo->topicNameLength <= ( MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX_LENGTH + 10U ) ) &&
+                 ( memcmp( pPublishInfo->pTopicName, MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX,
+                           MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX_LENGTH ) == 0 );
+
+    for( i = MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX_LENGTH; ( validTopic == true ) && ( i < pPublishInfo->topicNameLength ); i++ )
+    {
+        if( ( pPublishInfo->pTopicName[ i ] < '0' ) || ( pPublishInfo->pTopicName[ i ] > '9' ) )
+        {
+            validTopic = false;
+        }
+        else
+        {
+            index = ( index * 10U ) + ( uint32_t ) ( pPublishInfo->pTopicName[ i ] - '0' );
+        }
+    }
+
+    if( ( validTopic == false ) || ( index >= MQTT_BENCHMARK_RETAINED_COUNT ) ||
+        ( pPublishInfo->payloadLength != MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE ) )
+    {
+        retainedStorm.unexpectedCount++;
+    }
+    else if( retainedStorm.received[ index ] == true )
+    {
+        retainedStorm.duplicateCount++;
+    }
+    else
+    {
+        retainedStorm.received[ index ] = true;
+        retainedStorm.receivedCount++;
+        retainedStorm.lastMessageTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Publish a retained message, or clear it with an empty payload, and
+ * wait for its PUBACK.
+ *
+ * @return true if the PUBACK is received.
+ */
+static bool publishRetainedMessage( uint32_t index,
+                                    size_t payloadLength )
+{
+    char topic[ MQTT_BENCHMARK_RETAINED_TOPIC_SIZE ];
+    MQTTPublishInfo_t publishInfo = { 0 };
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.retain = true;
+    publishInfo.pTopicName = topic;
+    publishInfo.topicNameLength = ( uint16_t ) snprintf( topic, sizeof( topic ), "%s%u",
+                                                         MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX,
+                                                         ( unsigned int ) index );
+    publishInfo.pPayload = ( payloadLength > 0U ) ? benchmarkPayload : NULL;
+    publishInfo.payloadLength = payloadLength;
+
+    receivedPubAck = false;
+    globalPublishPacketIdentifier = MQTT_GetPacketId( &context );
+
+    return ( MQTT_Publish( &context, &publishInfo, globalPublishPacketIdentifier ) == MQTTSuccess ) &&
+           ( waitForPublishAck( &context, MQTTQoS1 ) == true );
+}
+
+/*-----------------------------------------------------------*/
+
+#ifdef MQTT_BENCHMARK_BURST_TOPIC
+
+/**
+ * @brief Transport recv function of the coalesced packet receive benchmark,
+ * counting the calls of the MQTT library to the recv function of the port.
+ */
+static int32_t countingRecv( NetworkContext_t * pNetworkContext,
+                             void * pBuffer,
+                             size_t bytesToRecv )
+{
+    int32_t result = MQTT_TEST_TRANSPORT_RECV( pNetworkContext, pBuffer, bytesToRecv );
+
+    if( ( result > 0 ) && ( coalescedReceive.recvBytes == 0U ) )
+    {
+        coalescedReceive.firstDataTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+    }
+
+    if( ( result > 0 ) || ( coalescedReceive.recvBytes > 0U ) )
+    {
+        coalescedReceive.recvCount++;
+    }
+
+    if( result > 0 )
+    {
+        coalescedReceive.dataRecvCount++;
+        coalescedReceive.recvBytes += ( uint32_t ) result;
+
+        if( ( uint32_t ) result > coalescedReceive.maxRecvBytes )
+        {
+            coalescedReceive.maxRecvBytes = ( uint32_t ) result;
+        }
+    }
+
+    return result;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Benchmark event callback counting the publishes of a burst of the
+ * coalesced packet receive benchmark.
+ */
+static void coalescedReceiveEventCallback( MQTTContext_t * pContext,
+                                           MQTTPacketInfo_t * pPacketInfo,
+                                           MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    const MQTTPublishInfo_t * pPublishInfo = pDeserializedInfo->pPublishInfo;
+
+    ( void ) pContext;
+
+    if( ( pPacketInfo->type & 0xF0U ) != MQTT_PACKET_TYPE_PUBLISH )
+    {
+        return;
+    }
+
+    if( ( pPublishInfo->topicNameLength == MQTT_BENCHMARK_BURST_TOPIC_LENGTH ) &&
+        ( memcmp( pPublishInfo->pTopicName, MQTT_BENCHMARK_BURST_TOPIC, MQTT_BENCHMARK_BURST_TOPIC_LENGTH ) == 0 ) &&
+        ( pPublishInfo->payloadLength == MQTT_BENCHMARK_BURST_PAYLOAD_SIZE ) )
+    {
+        coalescedReceive.receivedCount++;
+        coalescedReceive.lastPacketTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+    }
+    else
+    {
+        coalescedReceive.unexpectedCount++;
+    }
+}
+
+#endif /* ifdef MQTT_BENCHMARK_BURST_TOPIC */
+
+/*-----------------------------------------------------------*/
+
+#ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS
+
+/**
+ * @brief Acquire the mutex of the process loop thread benchmark and record
+ * whether, and for how long, another thread held it.
+ */
+static void lockBenchmarkMutex( BenchmarkLockStats_t * pLockStats )
+{
+    uint32_t startUs;
+    uint32_t waitUs;
+
+    if( FRTest_MutexTryLock( processLoopThreadBenchmark.mutex ) != 0 )
+    {
+        startUs = MQTT_BENCHMARK_GET_TIME_US();
+        FRTest_MutexLock( processLoopThreadBenchmark.mutex );
+        waitUs = MQTT_BENCHMARK_GET_TIME_US() - startUs;
+
+        pLockStats->contendedCount++;
+        pLockStats->totalWaitUs += waitUs;
+
+        if( waitUs > pLockStats->maxWaitUs )
+        {
+            pLockStats->maxWaitUs = waitUs;
+        }
+    }
+
+    pLockStats->lockCount++;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Event callback of the process loop thread benchmark, called by the
+ * process loop thread with the mutex held. The received messages are checked
+ * for corruption and for their order per publisher. The callback does not
+ * assert, as test assertions can only be used in the test thread.
+ */
+static void processLoopThreadEventCallback( MQTTContext_t * pContext,
+                                            MQTTPacketInfo_t * pPacketInfo,
+                                            MQTTDeserializedInfo_t * pDeserializedInfo )
+{
+    const MQTTPublishInfo_t * pPublishInfo = pDeserializedInfo->pPublishInfo;
+    const uint8_t * pPayload;
+    uint32_t sequence;
+    uint8_t publisherIndex;
+    size_t i;
+
+    ( void ) pContext;
+
+    if( pPacketInfo->type == MQTT_PACKET_TYPE_SUBACK )
+    {
+        processLoopThreadBenchmark.subAckReceived = true;
+        return;
+    }
+
+    if( pPacketInfo->type == MQTT_PACKET_TYPE_PUBACK )
+    {
+        processLoopThreadBenchmark.pubAckCount++;
+        return;
+    }
+
+    if( ( pPacketInfo->type & 0xF0U ) != MQTT_PACKET_TYPE_PUBLISH )
+    {
+        return;
+    }
+
+    pPayload = pPublishInfo->pPayload;
+
+    if( ( pPublishInfo->payloadLength != MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE ) ||
+        ( pPayload[ 0 ] >= MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT ) )
+    {
+        processLoopThreadBenchmark.corruptedCount++;
+        return;
+    }
+
+    publisherIndex = pPayload[ 0 ];
+    ( void ) memcpy( &sequence, &pPayload[ 1 ], sizeof( sequence ) );
+
+    for( i = MQTT_BENCHMARK_PUBLISHER_HEADER_SIZE; i < MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE; i++ )
+    {
+        if( pPayload[ i ] != ( uint8_t ) ( i + publisherIndex ) )
+        {
+            processLoopThreadBenchmark.corruptedCount++;
+            return;
+        }
+    }
+
+    if( sequence != processLoopThreadBenchmark.nextSequence[ publisherIndex ] )
+    {
+        processLoopThreadBenchmark.outOfOrderCount++;
+    }
+
+    processLoopThreadBenchmark.nextSequence[ publisherIndex ] = sequence + 1U;
+    processLoopThreadBenchmark.receivedCount++;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Thread function calling MQTT_ProcessLoop on the benchmark context,
+ * with the mutex held, until the benchmark stops it or the call fails.
+ */
+static void processLoopThread( void * pParam )
+{
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+
+    ( void ) pParam;
+
+    while( ( processLoopThreadBenchmark.stopFlag == false ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) )
+    {
+        lockBenchmarkMutex( &processLoopThreadBenchmark.lockStats );
+        xMQTTStatus = MQTT_ProcessLoop( processLoopThreadBenchmark.pContext );
+        processLoopThreadBenchmark.processLoopStatus = xMQTTStatus;
+        processLoopThreadBenchmark.processLoopCount++;
+        FRTest_MutexUnlock( processLoopThreadBenchmark.mutex );
+
+        /* Let the publisher threads waiting for the mutex run. */
+        FRTest_TimeDelay( 0U );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Thread function of a publisher of the process loop thread benchmark.
+ * The thread publishes MQTT_BENCHMARK_PUBLISH_COUNT QoS 1 messages to
+ * TEST_MQTT_TOPIC with the mutex held. The PUBACKs are received by the process
+ * loop thread.
+ */
+static void publisherThread( void * pParam )
+{
+    PublisherThread_t * pPublisher = pParam;
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t xMQTTStatus;
+
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.pTopicName = TEST_MQTT_TOPIC;
+    publishInfo.topicNameLength = TEST_MQTT_TOPIC_LENGTH;
+    publishInfo.pPayload = pPublisher->payload;
+    publishInfo.payloadLength = MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE;
+
+    pPublisher->result = true;
+
+    while( ( pPublisher->result == true ) && ( processLoopThreadBenchmark.stopFlag == false ) &&
+           ( pPublisher->publishedCount < MQTT_BENCHMARK_PUBLISH_COUNT ) )
+    {
+        ( void ) memcpy( &pPublisher->payload[ 1 ], &pPublisher->publishedCount, sizeof( uint32_t ) );
+
+        lockBenchmarkMutex( &pPublisher->lockStats );
+        xMQTTStatus = MQTT_Publish( processLoopThreadBenchmark.pContext,
+                                    &publishInfo,
+                                    MQTT_GetPacketId( processLoopThreadBenchmark.pContext ) );
+        FRTest_MutexUnlock( processLoopThreadBenchmark.mutex );
+
+        if( xMQTTStatus == MQTTSuccess )
+        {
+            pPublisher->publishedCount++;
+        }
+        else if( xMQTTStatus == MQTTNoMemory )
+        {
+            /* Every outgoing publish record is in use, wait for the process
+             * loop thread to receive PUBACKs. */
+            pPublisher->windowFullCount++;
+            FRTest_TimeDelay( 1U );
+        }
+        else
+        {
+            pPublisher->result = false;
+        }
+    }
+}
+
+#endif /* ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Comparison function to sort latencies with qsort.
+ */
+static int compareLatency( const void * pFirst,
+                           const void * pSecond )
+{
+    uint32_t first = *( const uint32_t * ) pFirst;
+    uint32_t second = *( const uint32_t * ) pSecond;
+
+    return ( first > second ) - ( first < second );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Call MQTT_ProcessLoop until the latency benchmark message with a
+ * sequence number is received or MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS expires.
+ */
+static MQTTStatus_t waitForLatencyMessage( MQTTContext_t * pContext,
+                                           uint32_t sequence )
+{
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+    uint32_t entryTime = FRTest_GetTimeMs();
+
+    while( ( latencyBenchmark.received[ sequence ] == false ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) )
+    {
+        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        {
+            /* Timeout. The message is counted as lost unless it arrives later. */
+            break;
+        }
+
+        xMQTTStatus = MQTT_ProcessLoop( pContext );
+    }
+
+    return xMQTTStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test setup function for MQTT benchmarks.
+ */
+TEST_SETUP( MqttBenchmark )
+{
+    #ifdef MQTT_TEST_TIME_WARP_FACTOR
+        /* The benchmarks measure real time. */
+        timeWarpEnabled = false;
+    #endif
+
+    connectTestSession();
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test tear down function for MQTT benchmarks.
+ */
+TEST_TEAR_DOWN( MqttBenchmark )
+{
+    disconnectBenchmarkClients();
+
+    /* A benchmark failing while the test context is disconnected leaves
+     * nothing to disconnect. */
+    if( testSessionConnected == true )
+    {
+        disconnectTestSession();
+    }
+
+    #ifdef MQTT_TEST_PACKET_TRACE
+        dumpPacketTrace();
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the sustained publish rate for each QoS level.
+ *
+ * For every size in MQTT_BENCHMARK_PAYLOAD_SIZES and every QoS level,
+ * MQTT_BENCHMARK_PUBLISH_COUNT messages are published to TEST_MQTT_TOPIC,
+ * which the test does not subscribe to. A QoS 1 or QoS 2 publish is sent once
+ * the previous one is acknowledged, so the rate includes one round trip to
+ * the broker per message. QoS 0 publishes are sent back to back and measure
+ * how fast the messages are handed to the transport. The number of messages
+ * and payload bytes per second are reported.
+ */
+TEST( MqttBenchmark, MQTT_Publish_Throughput )
+{
+    static const size_t payloadSizes[] = MQTT_BENCHMARK_PAYLOAD_SIZES;
+    size_t sizeIndex;
+    size_t i;
+    uint32_t qos;
+    uint32_t messageCount;
+    uint32_t startTimeMs;
+    uint32_t elapsedMs;
+
+    for( i = 0; i < sizeof( benchmarkPayload ); i++ )
+    {
+        benchmarkPayload[ i ] = ( uint8_t ) i;
+    }
+
+    for( sizeIndex = 0; sizeIndex < ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ); sizeIndex++ )
+    {
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), payloadSizes[ sizeIndex ],
+                                                  "MQTT_BENCHMARK_PAYLOAD_SIZES exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+        for( qos = MQTTQoS0; qos <= MQTTQoS2; qos++ )
+        {
+            startTimeMs = FRTest_GetTimeMs();
+
+            for( messageCount = 0; messageCount < MQTT_BENCHMARK_PUBLISH_COUNT; messageCount++ )
+            {
+                receivedPubAck = false;
+                receivedPubComp = false;
+
+                TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context,
+                                                                         TEST_MQTT_TOPIC,
+                                                                         ( MQTTQoS_t ) qos,
+                                                                         payloadSizes[ sizeIndex ],
+                                                                         MQTT_GetPacketId( &context ) ) );
+
+                if( qos != MQTTQoS0 )
+                {
+                    TEST_ASSERT_TRUE_MESSAGE( waitForPublishAck( &context, ( MQTTQoS_t ) qos ),
+                                              "Publish was not acknowledged." );
+                }
+            }
+
+            elapsedMs = FRTest_GetTimeMs() - startTimeMs;
+
+            printBenchmarkResult( "Publish throughput: QoS %u, %u byte payload, %u messages in %u ms, "
+                                  "%u messages/s, %lu bytes/s.",
+                                  ( unsigned int ) qos,
+                                  ( unsigned int ) payloadSizes[ sizeIndex ],
+                                  ( unsigned int ) MQTT_BENCHMARK_PUBLISH_COUNT,
+                                  ( unsigned int ) elapsedMs,
+                                  ( unsigned int ) getBenchmarkRate( MQTT_BENCHMARK_PUBLISH_COUNT, elapsedMs, MQTT_ONE_SECOND_TO_MS ),
+                                  ( unsigned long ) getBenchmarkRate( ( uint64_t ) MQTT_BENCHMARK_PUBLISH_COUNT * payloadSizes[ sizeIndex ], elapsedMs, MQTT_ONE_SECOND_TO_MS ) );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the end-to-end latency from publishing a message to
+ * receiving it back from the broker.
+ *
+ * The test subscribes to TEST_MQTT_TOPIC and, for QoS 0 and QoS 1, publishes
+ * MQTT_BENCHMARK_LATENCY_SAMPLES messages to it. Each payload carries a
+ * sequence number and the MQTT_BENCHMARK_GET_TIME_US() timestamp of the
+ * publish. A message is published once the previous one is received or
+ * MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS expires, so the latencies are not
+ * inflated by queueing. The latency is computed in the event callback when a
+ * message is received. The p50, p99 and maximum latencies are reported with
+ * the number of lost, reordered and duplicate messages. Lost QoS 1 messages
+ * fail the test.
+ */
+TEST( MqttBenchmark, MQTT_Publish_Receive_Latency )
+{
+    MQTTStatus_t xMQTTStatus;
+    uint32_t qos;
+    uint32_t sequence;
+    uint32_t sendTimeUs;
+    uint32_t entryTime;
+    uint32_t lostCount;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+    TEST_ASSERT_GREATER_OR_EQUAL_size_t_MESSAGE( MQTT_BENCHMARK_LATENCY_HEADER_SIZE, MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE,
+                                                 "MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE is too small." );
+
+    /* Subscribe with QoS 1 so that the messages are delivered back with the
+     * QoS they are published with. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, subscribeToTopic( &context, TEST_MQTT_TOPIC, MQTTQoS1 ) );
+
+    entryTime = FRTest_GetTimeMs();
+
+    do
+    {
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+
+        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        {
+            /* Timeout. */
+            break;
+        }
+        else if( receivedSubAck != 0 )
+        {
+            break;
+        }
+        else
+        {
+            /* Nothing to do. */
+        }
+    } while( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) );
+
+    TEST_ASSERT_TRUE( receivedSubAck );
+
+    ( void ) memset( benchmarkPayload, 0x00, MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE );
+
+    for( qos = MQTTQoS0; qos <= MQTTQoS1; qos++ )
+    {
+        ( void ) memset( &latencyBenchmark, 0x00, sizeof( latencyBenchmark ) );
+        benchmarkEventCallback = latencyEventCallback;
+
+        for( sequence = 0; sequence < MQTT_BENCHMARK_LATENCY_SAMPLES; sequence++ )
+        {
+            sendTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+            ( void ) memcpy( benchmarkPayload, &sequence, sizeof( sequence ) );
+            ( void ) memcpy( &benchmarkPayload[ sizeof( sequence ) ], &sendTimeUs, sizeof( sendTimeUs ) );
+
+            TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context,
+                                                                     TEST_MQTT_TOPIC,
+                                                                     ( MQTTQoS_t ) qos,
+                                                                     MQTT_BENCHMARK_LATENCY_PAYLOAD_SIZE,
+                                                                     MQTT_GetPacketId( &context ) ) );
+
+            xMQTTStatus = waitForLatencyMessage( &context, sequence );
+            TEST_ASSERT_TRUE( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) );
+        }
+
+        /* Receive the late messages and the remaining acknowledgements. */
+        entryTime = FRTest_GetTimeMs();
+
+        do
+        {
+            xMQTTStatus = MQTT_ProcessLoop( &context );
+        } while( ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+                 ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) );
+
+        benchmarkEventCallback = NULL;
+
+        lostCount = MQTT_BENCHMARK_LATENCY_SAMPLES - latencyBenchmark.receivedCount;
+        TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE( 0U, latencyBenchmark.receivedCount,
+                                                 "No latency benchmark message was received." );
+
+        qsort( latencyBenchmark.latencyUs, latencyBenchmark.receivedCount, sizeof( uint32_t ), compareLatency );
+
+        printBenchmarkResult( "Latency: QoS %u, %u samples, p50 %u us, p99 %u us, max %u us, "
+                              "%u lost, %u reordered, %u duplicates, %u unexpected.",
+                              ( unsigned int ) qos,
+                              ( unsigned int ) latencyBenchmark.receivedCount,
+                              ( unsigned int ) getLatencyPercentile( latencyBenchmark.latencyUs, latencyBenchmark.receivedCount, 50U ),
+                              ( unsigned int ) getLatencyPercentile( latencyBenchmark.latencyUs, latencyBenchmark.receivedCount, 99U ),
+                              ( unsigned int ) latencyBenchmark.latencyUs[ latencyBenchmark.receivedCount - 1U ],
+                              ( unsigned int ) lostCount,
+                              ( unsigned int ) latencyBenchmark.reorderedCount,
+                              ( unsigned int ) latencyBenchmark.duplicateCount,
+                              ( unsigned int ) latencyBenchmark.unexpectedCount );
+
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, latencyBenchmark.unexpectedCount,
+                                          "Received publishes which are not latency benchmark messages." );
+
+        if( qos == MQTTQoS1 )
+        {
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, lostCount, "QoS 1 messages were lost." );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the QoS 1 and QoS 2 publish throughput with several
+ * publishes in flight.
+ *
+ * For each window size, from 1 doubling up to OUTGOING_PUBLISH_RECORD_COUNT,
+ * MQTT_BENCHMARK_PUBLISH_COUNT publishes are sent while keeping up to window
+ * size publishes unacknowledged. A new publish is sent as soon as a PUBACK or
+ * PUBCOMP frees a slot, which fills the outgoing records passed to
+ * MQTT_InitStatefulQoS. The results show the throughput gained by each
+ * record, to size OUTGOING_PUBLISH_RECORD_COUNT for the RAM budget.
+ */
+TEST( MqttBenchmark, MQTT_Publish_Windowed_Throughput )
+{
+    MQTTStatus_t xMQTTStatus;
+    uint32_t qos;
+    uint32_t windowSize;
+    uint32_t publishedCount;
+    uint32_t lastCompletedCount;
+    uint32_t progressTimeMs;
+    uint32_t startTimeMs;
+    uint32_t elapsedMs;
+    size_t i;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+    for( i = 0; i < sizeof( benchmarkPayload ); i++ )
+    {
+        benchmarkPayload[ i ] = ( uint8_t ) i;
+    }
+
+    benchmarkEventCallback = windowEventCallback;
+
+    for( qos = MQTTQoS1; qos <= MQTTQoS2; qos++ )
+    {
+        windowSize = 1U;
+
+        while( windowSize <= OUTGOING_PUBLISH_RECORD_COUNT )
+        {
+            publishedCount = 0U;
+            completedPublishCount = 0U;
+            lastCompletedCount = 0U;
+            xMQTTStatus = MQTTSuccess;
+            startTimeMs = FRTest_GetTimeMs();
+            progressTimeMs = startTimeMs;
+
+            while( completedPublishCount < MQTT_BENCHMARK_PUBLISH_COUNT )
+            {
+                if( ( publishedCount < MQTT_BENCHMARK_PUBLISH_COUNT ) &&
+                    ( ( publishedCount - completedPublishCount ) < windowSize ) )
+                {
+                    TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context,
+                                                                             TEST_MQTT_TOPIC,
+                                                                             ( MQTTQoS_t ) qos,
+                                                                             MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                                                                             MQTT_GetPacketId( &context ) ) );
+                    publishedCount++;
+                }
+                else
+                {
+                    xMQTTStatus = MQTT_ProcessLoop( &context );
+                    TEST_ASSERT_TRUE( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) );
+
+                    if( completedPublishCount != lastCompletedCount )
+                    {
+                        lastCompletedCount = completedPublishCount;
+                        progressTimeMs = FRTest_GetTimeMs();
+                    }
+                    else if( FRTest_GetTimeMs() > ( progressTimeMs + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+                    {
+                        TEST_FAIL_MESSAGE( "Publishes in flight were not acknowledged." );
+                    }
+                    else
+                    {
+                        /* Wait for the acknowledgements. */
+                    }
+                }
+            }
+
+            elapsedMs = FRTest_GetTimeMs() - startTimeMs;
+
+            printBenchmarkResult( "Windowed publish throughput: QoS %u, window %u, %u byte payload, "
+                                  "%u messages in %u ms, %u messages/s.",
+                                  ( unsigned int ) qos,
+                                  ( unsigned int ) windowSize,
+                                  ( unsigned int ) MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                                  ( unsigned int ) MQTT_BENCHMARK_PUBLISH_COUNT,
+                                  ( unsigned int ) elapsedMs,
+                                  ( unsigned int ) getBenchmarkRate( MQTT_BENCHMARK_PUBLISH_COUNT, elapsedMs, MQTT_ONE_SECOND_TO_MS ) );
+
+            /* Double the window and finish with the full record count. */
+            if( windowSize == OUTGOING_PUBLISH_RECORD_COUNT )
+            {
+                break;
+            }
+            else if( ( windowSize * 2U ) > OUTGOING_PUBLISH_RECORD_COUNT )
+            {
+                windowSize = OUTGOING_PUBLISH_RECORD_COUNT;
+            }
+            else
+            {
+                windowSize *= 2U;
+            }
+        }
+    }
+
+    benchmarkEventCallback = NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the latency of each phase of the QoS 2 handshake and the
+ * number of complete exchanges per second.
+ *
+ * MQTT_BENCHMARK_PUBLISH_COUNT QoS 2 publishes are sent back to back, each
+ * once the previous one is completed, then with up to
+ * OUTGOING_PUBLISH_RECORD_COUNT exchanges in flight. The PUBLISH to PUBREC and
+ * PUBREL to PUBCOMP latencies are measured with MQTT_BENCHMARK_GET_TIME_US()
+ * and their p50, p99 and maximum are reported for each run, to weigh the cost
+ * of the exactly once delivery.
+ */
+TEST( MqttBenchmark, MQTT_Qos2_Handshake )
+{
+    static const uint32_t windowSizes[] = { 1U, OUTGOING_PUBLISH_RECORD_COUNT };
+    MQTTStatus_t xMQTTStatus;
+    uint32_t windowSize;
+    uint32_t publishedCount;
+    uint32_t lastCompletedCount;
+    uint32_t progressTimeMs;
+    uint32_t startTimeMs;
+    uint32_t elapsedMs;
+    uint16_t packetId;
+    size_t slot;
+    size_t run;
+    size_t i;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+    for( i = 0; i < sizeof( benchmarkPayload ); i++ )
+    {
+        benchmarkPayload[ i ] = ( uint8_t ) i;
+    }
+
+    benchmarkEventCallback = qos2EventCallback;
+
+    for( run = 0; run < ( sizeof( windowSizes ) / sizeof( windowSizes[ 0 ] ) ); run++ )
+    {
+        windowSize = windowSizes[ run ];
+        ( void ) memset( &qos2Benchmark, 0x00, sizeof( qos2Benchmark ) );
+        publishedCount = 0U;
+        lastCompletedCount = 0U;
+        startTimeMs = FRTest_GetTimeMs();
+        progressTimeMs = startTimeMs;
+
+        while( qos2Benchmark.pubCompCount < MQTT_BENCHMARK_PUBLISH_COUNT )
+        {
+            if( ( publishedCount < MQTT_BENCHMARK_PUBLISH_COUNT ) &&
+                ( ( publishedCount - qos2Benchmark.pubCompCount ) < windowSize ) )
+            {
+                for( slot = 0; qos2Benchmark.packetIds[ slot ] != 0U; slot++ )
+                {
+                    /* A slot is free while the window is not full. */
+                }
+
+                packetId = MQTT_GetPacketId( &context );
+                qos2Benchmark.packetIds[ slot ] = packetId;
+                qos2Benchmark.publishTimeUs[ slot ] = MQTT_BENCHMARK_GET_TIME_US();
+
+                TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context,
+                                                                         TEST_MQTT_TOPIC,
+                                                                         MQTTQoS2,
+                                                                         MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                                                                         packetId ) );
+                publishedCount++;
+            }
+            else
+            {
+                xMQTTStatus = MQTT_ProcessLoop( &context );
+                TEST_ASSERT_TRUE( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) );
+
+                if( qos2Benchmark.pubCompCount != lastCompletedCount )
+                {
+                    lastCompletedCount = qos2Benchmark.pubCompCount;
+                    progressTimeMs = FRTest_GetTimeMs();
+                }
+                else if( FRTest_GetTimeMs() > ( progressTimeMs + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+                {
+                    TEST_FAIL_MESSAGE( "QoS 2 exchanges in flight were not completed." );
+                }
+                else
+                {
+                    /* Wait for the acknowledgements. */
+                }
+            }
+        }
+
+        elapsedMs = FRTest_GetTimeMs() - startTimeMs;
+
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, qos2Benchmark.unexpectedCount,
+                                          "Acknowledgements did not match a publish in flight." );
+        TEST_ASSERT_EQUAL_UINT32( MQTT_BENCHMARK_PUBLISH_COUNT, qos2Benchmark.pubRecCount );
+
+        qsort( qos2Benchmark.pubRecLatencyUs, MQTT_BENCHMARK_PUBLISH_COUNT, sizeof( uint32_t ), compareLatency );
+        qsort( qos2Benchmark.pubCompLatencyUs, MQTT_BENCHMARK_PUBLISH_COUNT, sizeof( uint32_t ), compareLatency );
+
+        printBenchmarkResult( "QoS 2 handshake: window %u, %u byte payload, %u exchanges in %u ms, %u exchanges/s.",
+                              ( unsigned int ) windowSize,
+                              ( unsigned int ) MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                              ( unsigned int ) MQTT_BENCHMARK_PUBLISH_COUNT,
+                              ( unsigned int ) elapsedMs,
+                              ( unsigned int ) getBenchmarkRate( MQTT_BENCHMARK_PUBLISH_COUNT, elapsedMs, MQTT_ONE_SECOND_TO_MS ) );
+        printBenchmarkResult( "QoS 2 handshake: window %u, PUBLISH to PUBREC p50 %u us, p99 %u us, max %u us.",
+                              ( unsigned int ) windowSize,
+                              ( unsigned int ) getLatencyPercentile( qos2Benchmark.pubRecLatencyUs, MQTT_BENCHMARK_PUBLISH_COUNT, 50U ),
+                              ( unsigned int ) getLatencyPercentile( qos2Benchmark.pubRecLatencyUs, MQTT_BENCHMARK_PUBLISH_COUNT, 99U ),
+                              ( unsigned int ) qos2Benchmark.pubRecLatencyUs[ MQTT_BENCHMARK_PUBLISH_COUNT - 1U ] );
+        printBenchmarkResult( "QoS 2 handshake: window %u, PUBREL to PUBCOMP p50 %u us, p99 %u us, max %u us.",
+                              ( unsigned int ) windowSize,
+                              ( unsigned int ) getLatencyPercentile( qos2Benchmark.pubCompLatencyUs, MQTT_BENCHMARK_PUBLISH_COUNT, 50U ),
+                              ( unsigned int ) getLatencyPercentile( qos2Benchmark.pubCompLatencyUs, MQTT_BENCHMARK_PUBLISH_COUNT, 99U ),
+                              ( unsigned int ) qos2Benchmark.pubCompLatencyUs[ MQTT_BENCHMARK_PUBLISH_COUNT - 1U ] );
+    }
+
+    benchmarkEventCallback = NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the cost of restoring a persistent session with pending
+ * QoS 1 publishes.
+ *
+ * MQTT_BENCHMARK_PENDING_PUBLISH_COUNT QoS 1 publishes are sent in a
+ * persistent session and the connection is dropped before their PUBACKs are
+ * processed, leaving them in the outgoing publish records. The test then
+ * measures the time to reconnect with the "clean session" flag set to 0, to
+ * resend the publishes found with MQTT_PublishToResend and to receive all
+ * their PUBACKs. The memory of the QoS records passed to MQTT_InitStatefulQoS
+ * is reported with the results.
+ */
+TEST( MqttBenchmark, MQTT_Session_Restore_Pending_Publishes )
+{
+    MQTTStatus_t xMQTTStatus;
+    MQTTStateCursor_t cursor = MQTT_STATE_CURSOR_INITIALIZER;
+    MQTTPublishInfo_t publishInfo;
+    uint16_t packetId;
+    uint32_t resentCount = 0;
+    uint32_t entryTime;
+    uint32_t startTimeMs;
+    uint32_t reconnectedTimeMs;
+    uint32_t resentTimeMs;
+    uint32_t drainedTimeMs;
+    uint32_t i;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( OUTGOING_PUBLISH_RECORD_COUNT, MQTT_BENCHMARK_PENDING_PUBLISH_COUNT,
+                                              "MQTT_BENCHMARK_PENDING_PUBLISH_COUNT exceeds OUTGOING_PUBLISH_RECORD_COUNT." );
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+    startPersistentSession();
+
+    for( i = 0; i < MQTT_BENCHMARK_PENDING_PUBLISH_COUNT; i++ )
+    {
+        TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context,
+                                                                 TEST_MQTT_TOPIC,
+                                                                 MQTTQoS1,
+                                                                 MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE,
+                                                                 MQTT_GetPacketId( &context ) ) );
+    }
+
+    /* Fail the receive so that none of the PUBACKs is processed. failedRecv
+     * drops the connection as a network handover would. */
+    context.transportInterface.recv = failedRecv;
+
+    entryTime = FRTest_GetTimeMs();
+
+    do
+    {
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+    } while( ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+             ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) );
+
+    TEST_ASSERT_EQUAL( MQTTRecvFailed, xMQTTStatus );
+
+    context.transportInterface.recv = MQTT_TEST_TRANSPORT_RECV;
+
+    completedPublishCount = 0U;
+    benchmarkEventCallback = windowEventCallback;
+
+    startTimeMs = FRTest_GetTimeMs();
+
+    resumePersistentSession();
+
+    reconnectedTimeMs = FRTest_GetTimeMs();
+
+    ( void ) memset( &publishInfo, 0x00, sizeof( publishInfo ) );
+    publishInfo.qos = MQTTQoS1;
+    publishInfo.dup = true;
+    publishInfo.pTopicName = TEST_MQTT_TOPIC;
+    publishInfo.topicNameLength = TEST_MQTT_TOPIC_LENGTH;
+    publishInfo.pPayload = benchmarkPayload;
+    publishInfo.payloadLength = MQTT_BENCHMARK_WINDOW_PAYLOAD_SIZE;
+
+    packetId = MQTT_PublishToResend( &context, &cursor );
+
+    while( packetId != MQTT_PACKET_ID_INVALID )
+    {
+        TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_Publish( &context, &publishInfo, packetId ) );
+        resentCount++;
+        packetId = MQTT_PublishToResend( &context, &cursor );
+    }
+
+    resentTimeMs = FRTest_GetTimeMs();
+
+    entryTime = resentTimeMs;
+    xMQTTStatus = MQTTSuccess;
+
+    while( ( completedPublishCount < resentCount ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+           ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+    {
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+    }
+
+    drainedTimeMs = FRTest_GetTimeMs();
+    benchmarkEventCallback = NULL;
+
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( MQTT_BENCHMARK_PENDING_PUBLISH_COUNT, resentCount,
+                                      "Not all the pending publishes were found for resend." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( resentCount, completedPublishCount,
+                                      "Not all the resent publishes were acknowledged." );
+
+    printBenchmarkResult( "Session restore: %u pending QoS 1 publishes, reconnect %u ms, resend %u ms, "
+                          "drain %u ms, total %u ms.",
+                          ( unsigned int ) resentCount,
+                          ( unsigned int ) ( reconnectedTimeMs - startTimeMs ),
+                          ( unsigned int ) ( resentTimeMs - reconnectedTimeMs ),
+                          ( unsigned int ) ( drainedTimeMs - resentTimeMs ),
+                          ( unsigned int ) ( drainedTimeMs - startTimeMs ) );
+    printBenchmarkResult( "Session restore: QoS records %u bytes, %u outgoing and %u incoming of %u bytes.",
+                          ( unsigned int ) ( ( OUTGOING_PUBLISH_RECORD_COUNT + INCOMING_PUBLISH_RECORD_COUNT ) * sizeof( MQTTPubAckInfo_t ) ),
+                          ( unsigned int ) OUTGOING_PUBLISH_RECORD_COUNT,
+                          ( unsigned int ) INCOMING_PUBLISH_RECORD_COUNT,
+                          ( unsigned int ) sizeof( MQTTPubAckInfo_t ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the cost of a large subscription table.
+ *
+ * MQTT_BENCHMARK_TOPIC_FILTER_COUNT topic filters, every tenth one with a
+ * single-level wildcard, are subscribed to in MQTT_BENCHMARK_SUBSCRIPTION_STEPS
+ * steps. The topic filters of a step are batched into SUBSCRIBE packets up to
+ * MQTT_TEST_NETWORK_BUFFER_SIZE bytes and MQTT_BENCHMARK_MAX_FILTERS_PER_SUBSCRIBE
+ * topic filters. For each step the test reports the time to serialize the
+ * SUBSCRIBE packets, the average SUBACK latency and the time to dispatch an
+ * incoming message matching a wildcard topic filter against all the
+ * subscriptions.
+ *
+ * @note AWS IoT Core limits the subscriptions per connection and topic filters
+ * per SUBSCRIBE packet, so run this benchmark against a broker without those
+ * limits, such as the one in tools/mqtt_broker.
+ */
+TEST( MqttBenchmark, MQTT_Subscription_Table )
+{
+    MQTTStatus_t xMQTTStatus;
+    MQTTFixedBuffer_t serializeBuffer;
+    char dispatchTopic[ MQTT_BENCHMARK_TOPIC_FILTER_SIZE ];
+    size_t remainingLength;
+    size_t packetSize;
+    size_t batchStart;
+    size_t batchCount;
+    size_t stepEnd;
+    uint32_t step;
+    uint32_t packetCount;
+    uint32_t serializeTimeUs;
+    uint32_t subAckTimeUs;
+    uint32_t startTimeUs;
+    uint32_t entryTime;
+    uint32_t i;
+
+    ( void ) memset( &subscriptionBenchmark, 0x00, sizeof( subscriptionBenchmark ) );
+
+    for( i = 0; i < MQTT_BENCHMARK_TOPIC_FILTER_COUNT; i++ )
+    {
+        if( ( i % 10U ) == 9U )
+        {
+            subscriptionBenchmark.subscriptions[ i ].topicFilterLength =
+                ( uint16_t ) snprintf( subscriptionBenchmark.topicFilters[ i ], MQTT_BENCHMARK_TOPIC_FILTER_SIZE,
+                                       "%s/group/%u/+", TEST_MQTT_TOPIC, ( unsigned int ) ( i / 10U ) );
+        }
+        else
+        {
+            subscriptionBenchmark.subscriptions[ i ].topicFilterLength =
+                ( uint16_t ) snprintf( subscriptionBenchmark.topicFilters[ i ], MQTT_BENCHMARK_TOPIC_FILTER_SIZE,
+                                       "%s/child/%u", TEST_MQTT_TOPIC, ( unsigned int ) i );
+        }
+
+        subscriptionBenchmark.subscriptions[ i ].pTopicFilter = subscriptionBenchmark.topicFilters[ i ];
+        subscriptionBenchmark.subscriptions[ i ].qos = MQTTQoS0;
+    }
+
+    serializeBuffer.pBuffer = benchmarkPayload;
+    serializeBuffer.size = sizeof( benchmarkPayload );
+
+    benchmarkEventCallback = subscriptionEventCallback;
+
+    for( step = 1U; step <= MQTT_BENCHMARK_SUBSCRIPTION_STEPS; step++ )
+    {
+        stepEnd = ( MQTT_BENCHMARK_TOPIC_FILTER_COUNT * step ) / MQTT_BENCHMARK_SUBSCRIPTION_STEPS;
+        packetCount = 0U;
+        serializeTimeUs = 0U;
+        subAckTimeUs = 0U;
+
+        batchStart = subscriptionBenchmark.subscribedCount;
+
+        while( batchStart < stepEnd )
+        {
+            /* Add topic filters to the batch while the SUBSCRIBE packet fits in
+             * the network buffer. */
+            batchCount = 1U;
+
+            while( ( ( batchStart + batchCount ) < stepEnd ) &&
+                   ( batchCount < MQTT_BENCHMARK_MAX_FILTERS_PER_SUBSCRIBE ) &&
+                   ( MQTT_GetSubscribePacketSize( &subscriptionBenchmark.subscriptions[ batchStart ],
+                                                  batchCount + 1U,
+                                                  &remainingLength,
+                                                  &packetSize ) == MQTTSuccess ) &&
+                   ( packetSize <= MQTT_TEST_NETWORK_BUFFER_SIZE ) )
+            {
+                batchCount++;
+            }
+
+            subscriptionBenchmark.subscribePacketId = MQTT_GetPacketId( &context );
+
+            /* Time the serialization of the SUBSCRIBE packet on its own, as
+             * MQTT_Subscribe also includes the network send. */
+            startTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+            TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_GetSubscribePacketSize( &subscriptionBenchmark.subscriptions[ batchStart ],
+                                                                         batchCount,
+                                                                         &remainingLength,
+                                                                         &packetSize ) );
+            TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_SerializeSubscribe( &subscriptionBenchmark.subscriptions[ batchStart ],
+                                                                     batchCount,
+                                                                     subscriptionBenchmark.subscribePacketId,
+                                                                     remainingLength,
+                                                                     &serializeBuffer ) );
+            serializeTimeUs += MQTT_BENCHMARK_GET_TIME_US() - startTimeUs;
+
+            subscriptionBenchmark.subAckReceived = false;
+            startTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+
+            TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_Subscribe( &context,
+                                                            &subscriptionBenchmark.subscriptions[ batchStart ],
+                                                            batchCount,
+                                                            subscriptionBenchmark.subscribePacketId ) );
+
+            entryTime = FRTest_GetTimeMs();
+            xMQTTStatus = MQTTSuccess;
+
+            while( ( subscriptionBenchmark.subAckReceived == false ) &&
+                   ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+                   ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+            {
+                xMQTTStatus = MQTT_ProcessLoop( &context );
+            }
+
+            subAckTimeUs += MQTT_BENCHMARK_GET_TIME_US() - startTimeUs;
+            TEST_ASSERT_TRUE_MESSAGE( subscriptionBenchmark.subAckReceived, "SUBACK was not received." );
+
+            packetCount++;
+            batchStart += batchCount;
+            subscriptionBenchmark.subscribedCount = batchStart;
+        }
+
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, subscriptionBenchmark.rejectedCount, "Topic filters were rejected." );
+
+        /* Publish to a topic matching the last wildcard topic filter. */
+        ( void ) snprintf( dispatchTopic, sizeof( dispatchTopic ), "%s/group/%u/0",
+                           TEST_MQTT_TOPIC, ( unsigned int ) ( ( stepEnd / 10U ) - 1U ) );
+        subscriptionBenchmark.dispatchedCount = 0U;
+        subscriptionBenchmark.matchCount = 0U;
+        subscriptionBenchmark.dispatchTimeUs = 0U;
+
+        for( i = 0; i < MQTT_BENCHMARK_DISPATCH_MESSAGE_COUNT; i++ )
+        {
+            TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context, dispatchTopic, MQTTQoS0, 16U, 0U ) );
+        }
+
+        entryTime = FRTest_GetTimeMs();
+        xMQTTStatus = MQTTSuccess;
+
+        while( ( subscriptionBenchmark.dispatchedCount < MQTT_BENCHMARK_DISPATCH_MESSAGE_COUNT ) &&
+               ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+               ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+        {
+            xMQTTStatus = MQTT_ProcessLoop( &context );
+        }
+
+        TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE( 0U, subscriptionBenchmark.dispatchedCount,
+                                                 "No message was received on the wildcard topic filter." );
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE( subscriptionBenchmark.dispatchedCount, subscriptionBenchmark.matchCount,
+                                          "Dispatched messages did not match exactly one topic filter." );
+
+        printBenchmarkResult( "Subscriptions: %u topic filters, %u SUBSCRIBE packets, serialize %u us, "
+                              "SUBACK %u us avg, dispatch %u us per message.",
+                              ( unsigned int ) subscriptionBenchmark.subscribedCount,
+                              ( unsigned int ) packetCount,
+                              ( unsigned int ) serializeTimeUs,
+                              ( unsigned int ) ( ( packetCount > 0U ) ? ( subAckTimeUs / packetCount ) : 0U ),
+                              ( unsigned int ) ( subscriptionBenchmark.dispatchTimeUs / subscriptionBenchmark.dispatchedCount ) );
+    }
+
+    benchmarkEventCallback = NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the aggregate throughput of concurrent MQTT clients.
+ *
+ * MQTT_BENCHMARK_CLIENT_COUNT clients, each with its own MQTT context, network
+ * buffer, connection and thread, subscribe to their own topic and publish
+ * MQTT_BENCHMARK_PUBLISH_COUNT QoS 1 messages to it at the same time. The
+ * first client uses the network context of the test fixture, the second one
+ * pSecondNetworkContext and the others pBenchmarkNetworkContexts of the test
+ * parameters. The aggregate throughput is computed from the messages sent and
+ * received by all the clients between the first client start and the last
+ * client end.
+ */
+TEST( MqttBenchmark, MQTT_Concurrent_Clients_Throughput )
+{
+    FRTestThreadHandle_t threadHandles[ MQTT_BENCHMARK_CLIENT_COUNT ] = { 0 };
+    uint32_t startTimeMs = 0;
+    uint32_t endTimeMs = 0;
+    uint32_t elapsedMs;
+    uint32_t totalPublished = 0;
+    uint32_t totalReceived = 0;
+    size_t threadCount;
+    size_t i;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_CLIENT_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_CLIENT_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( testParam.benchmarkNetworkContextCount + 2U, MQTT_BENCHMARK_CLIENT_COUNT,
+                                              "MQTT_BENCHMARK_CLIENT_COUNT exceeds the network contexts in the test parameters." );
+    TEST_ASSERT_NOT_NULL( testParam.pSecondNetworkContext );
+
+    for( i = 0; i < sizeof( benchmarkPayload ); i++ )
+    {
+        benchmarkPayload[ i ] = ( uint8_t ) i;
+    }
+
+    ( void ) memset( benchmarkClients, 0x00, sizeof( benchmarkClients ) );
+
+    /* The first client connects the network context of the test fixture with
+     * its own MQTT context, so that the client threads only run the benchmark
+     * event callback, which does not assert. */
+    disconnectTestSession();
+
+    for( i = 0; i < MQTT_BENCHMARK_CLIENT_COUNT; i++ )
+    {
+        benchmarkClients[ i ].topicLength = ( uint16_t ) snprintf( benchmarkClients[ i ].topic,
+                                                                   sizeof( benchmarkClients[ i ].topic ),
+                                                                   "%s/%u", TEST_MQTT_TOPIC,
+                                                                   ( unsigned int ) i );
+
+        if( i == 0U )
+        {
+            benchmarkClients[ i ].pNetworkContext = testParam.pNetworkContext;
+        }
+        else if( i == 1U )
+        {
+            benchmarkClients[ i ].pNetworkContext = testParam.pSecondNetworkContext;
+        }
+        else
+        {
+            benchmarkClients[ i ].pNetworkContext = testParam.pBenchmarkNetworkContexts[ i - 2U ];
+        }
+
+        connectBenchmarkClient( i, benchmarkClientEventCallback, NULL );
+    }
+
+    for( threadCount = 0; threadCount < MQTT_BENCHMARK_CLIENT_COUNT; threadCount++ )
+    {
+        threadHandles[ threadCount ] = FRTest_ThreadCreate( benchmarkClientThread, &benchmarkClients[ threadCount ] );
+
+        if( threadHandles[ threadCount ] == NULL )
+        {
+            break;
+        }
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE( joinBenchmarkClientThreads( threadHandles, threadCount ),
+                              "Create or wait for benchmark client threads failed." );
+
+    for( i = 0; i < MQTT_BENCHMARK_CLIENT_COUNT; i++ )
+    {
+        TEST_ASSERT_TRUE_MESSAGE( benchmarkClients[ i ].result, "Benchmark client failed." );
+
+        if( ( i == 0U ) || ( ( int32_t ) ( benchmarkClients[ i ].startTimeMs - startTimeMs ) < 0 ) )
+        {
+            startTimeMs = benchmarkClients[ i ].startTimeMs;
+        }
+
+        if( ( i == 0U ) || ( ( int32_t ) ( benchmarkClients[ i ].endTimeMs - endTimeMs ) > 0 ) )
+        {
+            endTimeMs = benchmarkClients[ i ].endTimeMs;
+        }
+
+        totalPublished += benchmarkClients[ i ].publishedCount;
+        totalReceived += benchmarkClients[ i ].receivedCount;
+    }
+
+    elapsedMs = endTimeMs - startTimeMs;
+
+    printBenchmarkResult( "Concurrent clients throughput: %u clients, %u byte payload, %u published and "
+                          "%u received in %u ms, %u messages/s.",
+                          ( unsigned int ) MQTT_BENCHMARK_CLIENT_COUNT,
+                          ( unsigned int ) MQTT_BENCHMARK_CLIENT_PAYLOAD_SIZE,
+                          ( unsigned int ) totalPublished,
+                          ( unsigned int ) totalReceived,
+                          ( unsigned int ) elapsedMs,
+                          ( unsigned int ) getBenchmarkRate( totalPublished + totalReceived, elapsedMs, MQTT_ONE_SECOND_TO_MS ) );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compares publishing through the transport writev with publishing
+ * through one send call per packet part.
+ *
+ * For every size in MQTT_BENCHMARK_PAYLOAD_SIZES, MQTT_BENCHMARK_PUBLISH_COUNT
+ * QoS 0 messages are published to TEST_MQTT_TOPIC with the writev function of
+ * the port, then again with writev set to NULL so that the MQTT library sends
+ * the header, topic and payload with separate send calls. Each run ends with a
+ * QoS 1 publish whose PUBACK confirms the broker received every message. The
+ * throughput and the time spent in MQTT_Publish, measured with
+ * MQTT_BENCHMARK_GET_TIME_US(), are reported for both methods. Only the send
+ * run is reported if the port has no writev.
+ */
+TEST( MqttBenchmark, MQTT_Publish_Writev_Versus_Send )
+{
+    static const size_t payloadSizes[] = MQTT_BENCHMARK_PAYLOAD_SIZES;
+    TransportWritev_t portWritev = context.transportInterface.writev;
+    size_t sizeIndex;
+    size_t i;
+    uint32_t method;
+    uint32_t messageCount;
+    uint32_t startTimeMs;
+    uint32_t elapsedMs;
+    uint32_t startTimeUs;
+    uint32_t publishTimeUs;
+
+    for( i = 0; i < sizeof( benchmarkPayload ); i++ )
+    {
+        benchmarkPayload[ i ] = ( uint8_t ) i;
+    }
+
+    for( sizeIndex = 0; sizeIndex < ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ); sizeIndex++ )
+    {
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), payloadSizes[ sizeIndex ],
+                                                  "MQTT_BENCHMARK_PAYLOAD_SIZES exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+        /* Method 0 publishes with writev, method 1 with send. */
+        for( method = ( portWritev != NULL ) ? 0U : 1U; method < 2U; method++ )
+        {
+            context.transportInterface.writev = ( method == 0U ) ? portWritev : NULL;
+            publishTimeUs = 0U;
+            startTimeMs = FRTest_GetTimeMs();
+
+            for( messageCount = 0; messageCount < MQTT_BENCHMARK_PUBLISH_COUNT; messageCount++ )
+            {
+                startTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+                TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context,
+                                                                         TEST_MQTT_TOPIC,
+                                                                         MQTTQoS0,
+                                                                         payloadSizes[ sizeIndex ],
+                                                                         0U ) );
+                publishTimeUs += MQTT_BENCHMARK_GET_TIME_US() - startTimeUs;
+            }
+
+            receivedPubAck = false;
+            TEST_ASSERT_EQUAL( MQTTSuccess, publishBenchmarkMessage( &context,
+                                                                     TEST_MQTT_TOPIC,
+                                                                     MQTTQoS1,
+                                                                     payloadSizes[ sizeIndex ],
+                                                                     MQTT_GetPacketId( &context ) ) );
+            TEST_ASSERT_TRUE_MESSAGE( waitForPublishAck( &context, MQTTQoS1 ),
+                                      "Publish was not acknowledged." );
+
+            elapsedMs = FRTest_GetTimeMs() - startTimeMs;
+
+            printBenchmarkResult( "Publish %s: %u byte payload, %u messages in %u ms, %u messages/s, "
+                                  "%lu bytes/s, %u us publishing.",
+                                  ( method == 0U ) ? "with writev" : "with send",
+                                  ( unsigned int ) payloadSizes[ sizeIndex ],
+                                  ( unsigned int ) MQTT_BENCHMARK_PUBLISH_COUNT,
+                                  ( unsigned int ) elapsedMs,
+                                  ( unsigned int ) getBenchmarkRate( MQTT_BENCHMARK_PUBLISH_COUNT, elapsedMs, MQTT_ONE_SECOND_TO_MS ),
+                                  ( unsigned long ) getBenchmarkRate( ( uint64_t ) MQTT_BENCHMARK_PUBLISH_COUNT * payloadSizes[ sizeIndex ], elapsedMs, MQTT_ONE_SECOND_TO_MS ),
+                                  ( unsigned int ) publishTimeUs );
+        }
+
+        context.transportInterface.writev = portWritev;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Finds the smallest network buffer that runs a publish and subscribe
+ * workload for each payload size.
+ *
+ * For every size in MQTT_BENCHMARK_PAYLOAD_SIZES, a session subscribes to
+ * TEST_MQTT_TOPIC and receives back a QoS 1 message it publishes to it. The
+ * workload is run with a slice of the network buffer of decreasing size,
+ * selected at run time by a binary search between MQTT_TEST_NETWORK_BUFFER_SIZE
+ * and 0. The smallest working size is reported with the size of the incoming
+ * PUBLISH packet, to set MQTT_TEST_NETWORK_BUFFER_SIZE or the network buffer
+ * of the application without rebuilding for each size.
+ */
+TEST( MqttBenchmark, MQTT_Network_Buffer_Size )
+{
+    static const size_t payloadSizes[] = MQTT_BENCHMARK_PAYLOAD_SIZES;
+    MQTTPublishInfo_t publishInfo = { 0 };
+    size_t sizeIndex;
+    size_t workingSize;
+    size_t failingSize;
+    size_t trialSize;
+    size_t remainingLength;
+    size_t packetSize;
+    uint32_t trialCount;
+    size_t i;
+
+    for( i = 0; i < sizeof( benchmarkPayload ); i++ )
+    {
+        benchmarkPayload[ i ] = ( uint8_t ) i;
+    }
+
+    /* The trials connect the test context with their own network buffer. */
+    disconnectTestSession();
+    benchmarkEventCallback = networkBufferTrialEventCallback;
+
+    for( sizeIndex = 0; sizeIndex < ( sizeof( payloadSizes ) / sizeof( payloadSizes[ 0 ] ) ); sizeIndex++ )
+    {
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), payloadSizes[ sizeIndex ],
+                                                  "MQTT_BENCHMARK_PAYLOAD_SIZES exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+        TEST_ASSERT_TRUE_MESSAGE( runNetworkBufferTrial( MQTT_TEST_NETWORK_BUFFER_SIZE, payloadSizes[ sizeIndex ] ),
+                                  "The workload failed with MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+        workingSize = MQTT_TEST_NETWORK_BUFFER_SIZE;
+        failingSize = 0U;
+        trialCount = 1U;
+
+        while( ( workingSize - failingSize ) > 1U )
+        {
+            trialSize = failingSize + ( ( workingSize - failingSize ) / 2U );
+
+            if( runNetworkBufferTrial( trialSize, payloadSizes[ sizeIndex ] ) == true )
+            {
+                workingSize = trialSize;
+            }
+            else
+            {
+                failingSize = trialSize;
+            }
+
+            trialCount++;
+        }
+
+        publishInfo.qos = MQTTQoS1;
+        publishInfo.pTopicName = TEST_MQTT_TOPIC;
+        publishInfo.topicNameLength = TEST_MQTT_TOPIC_LENGTH;
+        publishInfo.payloadLength = payloadSizes[ sizeIndex ];
+        TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_GetPublishPacketSize( &publishInfo, &remainingLength, &packetSize ) );
+
+        printBenchmarkResult( "Network buffer: %u byte payload, smallest working buffer %u bytes, "
+                              "incoming PUBLISH %u bytes, %u trials.",
+                              ( unsigned int ) payloadSizes[ sizeIndex ],
+                              ( unsigned int ) workingSize,
+                              ( unsigned int ) packetSize,
+                              ( unsigned int ) trialCount );
+    }
+
+    /* Connect the test context again for the tear down. */
+    connectTestSession();
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the PINGREQ to PINGRESP round trip time and its jitter.
+ *
+ * The keep-alive interval of the MQTT context is lowered to
+ * MQTT_BENCHMARK_PING_KEEP_ALIVE_SECONDS so that MQTT_ProcessLoop sends a
+ * PINGREQ every interval on the idle connection. The round trip is measured
+ * from the time MQTT_ProcessLoop returns with a PINGREQ sent to the time it
+ * returns with the PINGRESP received, with MQTT_BENCHMARK_GET_TIME_US(), and
+ * from the pingReqSendTimeMs and lastPacketRxTime timestamps of the context.
+ * The jitter is the mean difference between consecutive round trips. The
+ * results give a baseline of the cheapest health metric of a port. The
+ * benchmark refuses to run if the context does not use the real clock, as
+ * the interval and the timestamps would be scaled by
+ * MQTT_TEST_TIME_WARP_FACTOR.
+ */
+TEST( MqttBenchmark, MQTT_Ping_Round_Trip )
+{
+    uint32_t roundTripUs[ MQTT_BENCHMARK_PING_COUNT ];
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+    uint16_t keepAliveIntervalSec = context.keepAliveIntervalSec;
+    uint32_t pingCount = 0U;
+    uint32_t pingSendTimeUs = 0U;
+    uint32_t roundTripMs;
+    uint32_t minRoundTripMs = UINT32_MAX;
+    uint32_t maxRoundTripMs = 0U;
+    uint32_t jitterSumUs = 0U;
+    uint32_t entryTime;
+    bool pingPending = false;
+
+    TEST_ASSERT_TRUE_MESSAGE( context.getTime == testParam.pGetTimeMs,
+                              "The ping round trip benchmark needs the real clock of the test parameters." );
+
+    context.keepAliveIntervalSec = MQTT_BENCHMARK_PING_KEEP_ALIVE_SECONDS;
+    entryTime = FRTest_GetTimeMs();
+
+    while( ( pingCount < MQTT_BENCHMARK_PING_COUNT ) &&
+           ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) )
+    {
+        if( FRTest_GetTimeMs() > ( entryTime + ( MQTT_BENCHMARK_PING_COUNT * ( MQTT_BENCHMARK_PING_KEEP_ALIVE_SECONDS + 1U ) * 1000U ) ) )
+        {
+            /* Timeout. */
+            break;
+        }
+
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+
+        if( ( pingPending == false ) && ( context.waitingForPingResp == true ) )
+        {
+            pingSendTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+            pingPending = true;
+        }
+        else if( ( pingPending == true ) && ( context.waitingForPingResp == false ) )
+        {
+            roundTripUs[ pingCount ] = MQTT_BENCHMARK_GET_TIME_US() - pingSendTimeUs;
+            roundTripMs = context.lastPacketRxTime - context.pingReqSendTimeMs;
+
+            if( roundTripMs < minRoundTripMs )
+            {
+                minRoundTripMs = roundTripMs;
+            }
+
+            if( roundTripMs > maxRoundTripMs )
+            {
+                maxRoundTripMs = roundTripMs;
+            }
+
+            if( pingCount > 0U )
+            {
+                jitterSumUs += ( roundTripUs[ pingCount ] > roundTripUs[ pingCount - 1U ] ) ?
+                               ( roundTripUs[ pingCount ] - roundTripUs[ pingCount - 1U ] ) :
+                               ( roundTripUs[ pingCount - 1U ] - roundTripUs[ pingCount ] );
+            }
+
+            pingCount++;
+            pingPending = false;
+        }
+        else
+        {
+            /* Wait for the next PINGREQ or for the PINGRESP. */
+        }
+    }
+
+    context.keepAliveIntervalSec = keepAliveIntervalSec;
+
+    TEST_ASSERT_TRUE_MESSAGE( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ),
+                              "MQTT_ProcessLoop failed, a PINGRESP may have been missed." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( MQTT_BENCHMARK_PING_COUNT, pingCount,
+                                      "Not every PINGREQ was answered in time." );
+
+    qsort( roundTripUs, pingCount, sizeof( uint32_t ), compareLatency );
+
+    printBenchmarkResult( "Ping round trip: %u pings, keep-alive %u s, min %u us, p50 %u us, p99 %u us, max %u us, "
+                          "jitter %u us.",
+                          ( unsigned int ) pingCount,
+                          ( unsigned int ) MQTT_BENCHMARK_PING_KEEP_ALIVE_SECONDS,
+                          ( unsigned int ) roundTripUs[ 0 ],
+                          ( unsigned int ) getLatencyPercentile( roundTripUs, pingCount, 50U ),
+                          ( unsigned int ) getLatencyPercentile( roundTripUs, pingCount, 99U ),
+                          ( unsigned int ) roundTripUs[ pingCount - 1U ],
+                          ( unsigned int ) ( ( pingCount > 1U ) ? ( jitterSumUs / ( pingCount - 1U ) ) : 0U ) );
+    printBenchmarkResult( "Ping round trip from the context timestamps: min %u ms, max %u ms.",
+                          ( unsigned int ) minRoundTripMs,
+                          ( unsigned int ) maxRoundTripMs );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures how a slow consumer falls behind a flooding publisher.
+ *
+ * The test context subscribes to TEST_MQTT_TOPIC with QoS 0, then a second
+ * MQTT context on pSecondNetworkContext publishes
+ * MQTT_BENCHMARK_FLOOD_MESSAGE_COUNT QoS 0 messages to it from its own thread
+ * as fast as it can. The test context spends
+ * MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS on every message it receives. The
+ * messages in flight are the messages, and bytes, sent by the flooding
+ * connection and not yet consumed, wherever they wait: in the broker, the
+ * network or the transport of the device. When
+ * MQTT_BENCHMARK_GET_RECV_PENDING() is defined, the bytes received by the
+ * transport of the device and not yet read by the MQTT library are sampled
+ * after every MQTT_ProcessLoop call, and their peak is the device backlog. The
+ * number
+ * of MQTT_ProcessLoop calls and the longest one, the keep-alive pings sent
+ * behind the backlog and the longest time without any packet sent by the
+ * device are reported. The keep-alive is missed when that time exceeds one
+ * and a half keep-alive interval, after which the broker may close the
+ * connection, or when MQTT_ProcessLoop returns MQTTKeepAliveTimeout. A missed
+ * keep-alive is reported, not failed.
+ */
+TEST( MqttBenchmark, MQTT_Slow_Consumer_Backlog )
+{
+    FRTestThreadHandle_t threadHandle;
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t xMQTTStatus;
+    size_t remainingLength = 0U;
+    size_t packetSize = 0U;
+    uint32_t entryTime;
+    uint32_t elapsedMs;
+    uint32_t lastProgressMs;
+    uint32_t consumedCount;
+    uint32_t backlogCount;
+    uint32_t peakBacklogCount = 0U;
+    uint32_t peakBacklogMs = 0U;
+
+    #ifdef MQTT_BENCHMARK_GET_RECV_PENDING
+        size_t pendingBytes;
+        size_t peakPendingBytes = 0U;
+        uint32_t peakPendingMs = 0U;
+    #endif
+    uint32_t callCount = 0U;
+    uint32_t callStartUs;
+    uint32_t callUs;
+    uint32_t maxCallUs = 0U;
+    uint32_t maxCallMessages = 0U;
+    uint32_t txGapMs;
+    uint32_t maxTxGapMs = 0U;
+    uint32_t pingCount = 0U;
+    uint32_t maxPingRoundTripMs = 0U;
+    uint32_t keepAliveMissMs = 0U;
+    bool keepAliveMissed = false;
+    bool pingPending = false;
+    bool floodThreadExited;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+    TEST_ASSERT_NOT_NULL( testParam.pSecondNetworkContext );
+
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = TEST_MQTT_TOPIC;
+    publishInfo.topicNameLength = TEST_MQTT_TOPIC_LENGTH;
+    publishInfo.payloadLength = MQTT_BENCHMARK_FLOOD_PAYLOAD_SIZE;
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_GetPublishPacketSize( &publishInfo, &remainingLength, &packetSize ) );
+
+    /* Subscribe with QoS 0 so that the device sends nothing but pings while it
+     * consumes the messages. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, subscribeToTopic( &context, TEST_MQTT_TOPIC, MQTTQoS0 ) );
+
+    entryTime = FRTest_GetTimeMs();
+
+    do
+    {
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+
+        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        {
+            /* Timeout. */
+            break;
+        }
+        else if( receivedSubAck != 0 )
+        {
+            break;
+        }
+        else
+        {
+            /* Nothing to do. */
+        }
+    } while( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) );
+
+    TEST_ASSERT_TRUE( receivedSubAck );
+
+    /* The flooding connection is the second benchmark client. */
+    ( void ) memset( benchmarkClients, 0x00, sizeof( benchmarkClients ) );
+    ( void ) memset( &slowConsumerBenchmark, 0x00, sizeof( slowConsumerBenchmark ) );
+    benchmarkClients[ 1 ].pNetworkContext = testParam.pSecondNetworkContext;
+    connectBenchmarkClient( 1, benchmarkClientEventCallback, NULL );
+
+    benchmarkEventCallback = slowConsumerEventCallback;
+    xMQTTStatus = MQTTSuccess;
+    entryTime = FRTest_GetTimeMs();
+    lastProgressMs = entryTime;
+
+    threadHandle = FRTest_ThreadCreate( floodThread, &benchmarkClients[ 1 ] );
+    TEST_ASSERT_MESSAGE( threadHandle != NULL, "Create thread failed." );
+
+    while( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) )
+    {
+        consumedCount = slowConsumerBenchmark.consumedCount;
+        callStartUs = MQTT_BENCHMARK_GET_TIME_US();
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+        callUs = MQTT_BENCHMARK_GET_TIME_US() - callStartUs;
+        callCount++;
+
+        if( callUs > maxCallUs )
+        {
+            maxCallUs = callUs;
+        }
+
+        if( slowConsumerBenchmark.consumedCount != consumedCount )
+        {
+            lastProgressMs = FRTest_GetTimeMs();
+
+            if( ( slowConsumerBenchmark.consumedCount - consumedCount ) > maxCallMessages )
+            {
+                maxCallMessages = slowConsumerBenchmark.consumedCount - consumedCount;
+            }
+        }
+
+        /* A message may be received before the flooding thread counts it. */
+        backlogCount = slowConsumerBenchmark.floodedCount;
+        consumedCount = slowConsumerBenchmark.consumedCount;
+        backlogCount = ( backlogCount > consumedCount ) ? ( backlogCount - consumedCount ) : 0U;
+
+        if( backlogCount > peakBacklogCount )
+        {
+            peakBacklogCount = backlogCount;
+            peakBacklogMs = FRTest_GetTimeMs() - entryTime;
+        }
+
+        #ifdef MQTT_BENCHMARK_GET_RECV_PENDING
+            pendingBytes = MQTT_BENCHMARK_GET_RECV_PENDING( testParam.pNetworkContext );
+
+            if( pendingBytes > peakPendingBytes )
+            {
+                peakPendingBytes = pendingBytes;
+                peakPendingMs = FRTest_GetTimeMs() - entryTime;
+            }
+        #endif
+
+        /* The context timestamps are taken with the time function of the
+         * MQTT context. */
+        txGapMs = testParam.pGetTimeMs() - context.lastPacketTxTime;
+
+        if( txGapMs > maxTxGapMs )
+        {
+            maxTxGapMs = txGapMs;
+        }
+
+        if( ( keepAliveMissed == false ) &&
+            ( ( txGapMs > ( context.keepAliveIntervalSec * 1500U ) ) || ( xMQTTStatus == MQTTKeepAliveTimeout ) ) )
+        {
+            keepAliveMissed = true;
+            keepAliveMissMs = FRTest_GetTimeMs() - entryTime;
+        }
+
+        if( ( pingPending == false ) && ( context.waitingForPingResp == true ) )
+        {
+            pingCount++;
+            pingPending = true;
+        }
+        else if( ( pingPending == true ) && ( context.waitingForPingResp == false ) )
+        {
+            if( ( context.lastPacketRxTime - context.pingReqSendTimeMs ) > maxPingRoundTripMs )
+            {
+                maxPingRoundTripMs = context.lastPacketRxTime - context.pingReqSendTimeMs;
+            }
+
+            pingPending = false;
+        }
+        else
+        {
+            /* Wait for the next PINGREQ or for the PINGRESP. */
+        }
+
+        if( ( slowConsumerBenchmark.floodDone == true ) &&
+            ( ( consumedCount >= slowConsumerBenchmark.floodedCount ) ||
+              ( FRTest_GetTimeMs() > ( lastProgressMs + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) ) )
+        {
+            /* Every message is consumed or the remaining ones are lost. */
+            break;
+        }
+
+        if( FRTest_GetTimeMs() > ( entryTime + MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS ) )
+        {
+            /* Timeout. */
+            break;
+        }
+    }
+
+    elapsedMs = lastProgressMs - entryTime;
+    benchmarkEventCallback = NULL;
+
+    /* The flooding thread is done unless the consumer failed or timed out,
+     * stop it before waiting for it. */
+    benchmarkClients[ 1 ].stopFlag = true;
+    floodThreadExited = ( FRTest_ThreadTimedJoin( threadHandle, MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS ) == 0 );
+
+    if( ( xMQTTStatus != MQTTSuccess ) && ( xMQTTStatus != MQTTNeedMoreBytes ) )
+    {
+        /* Connect the test context again for the tear down as the broker may
+         * have closed the connection. */
+        ( void ) MQTT_Disconnect( &context );
+        ( *testParam.pNetworkDisconnect )( testParam.pNetworkContext );
+        connectTestSession();
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE( floodThreadExited, "Waiting for the flooding thread exit failed." );
+    TEST_ASSERT_TRUE_MESSAGE( slowConsumerBenchmark.floodResult, "Flooding publish failed." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, slowConsumerBenchmark.unexpectedCount,
+                                      "Received messages of an unexpected size." );
+
+    printBenchmarkResult( "Slow consumer: %u ms per message, %u of %u messages of %u bytes consumed in %u ms, "
+                          "flooded in %u ms, %u messages/s.",
+                          ( unsigned int ) MQTT_BENCHMARK_SLOW_CONSUMER_COST_MS,
+                          ( unsigned int ) slowConsumerBenchmark.consumedCount,
+                          ( unsigned int ) slowConsumerBenchmark.floodedCount,
+                          ( unsigned int ) packetSize,
+                          ( unsigned int ) elapsedMs,
+                          ( unsigned int ) ( slowConsumerBenchmark.floodEndMs - slowConsumerBenchmark.floodStartMs ),
+                          ( unsigned int ) getBenchmarkRate( slowConsumerBenchmark.consumedCount, elapsedMs, MQTT_ONE_SECOND_TO_MS ) );
+    printBenchmarkResult( "Slow consumer: peak in flight %u messages, %u bytes, at %u ms, %u process loop calls, "
+                          "longest %u us, most messages in a call %u, status %s.",
+                          ( unsigned int ) peakBacklogCount,
+                          ( unsigned int ) ( peakBacklogCount * packetSize ),
+                          ( unsigned int ) peakBacklogMs,
+                          ( unsigned int ) callCount,
+                          ( unsigned int ) maxCallUs,
+                          ( unsigned int ) maxCallMessages,
+                          MQTT_Status_strerror( xMQTTStatus ) );
+
+    #ifdef MQTT_BENCHMARK_GET_RECV_PENDING
+        printBenchmarkResult( "Slow consumer: peak device backlog %u bytes at %u ms.",
+                              ( unsigned int ) peakPendingBytes,
+                              ( unsigned int ) peakPendingMs );
+    #endif
+
+    if( keepAliveMissed == true )
+    {
+        printBenchmarkResult( "Slow consumer: keep-alive %u s missed at %u ms, %u pings, longest PINGRESP %u ms, "
+                              "longest send gap %u ms.",
+                              ( unsigned int ) MQTT_KEEP_ALIVE_INTERVAL_SECONDS,
+                              ( unsigned int ) keepAliveMissMs,
+                              ( unsigned int ) pingCount,
+                              ( unsigned int ) maxPingRoundTripMs,
+                              ( unsigned int ) maxTxGapMs );
+    }
+    else
+    {
+        printBenchmarkResult( "Slow consumer: keep-alive %u s kept, %u pings, longest PINGRESP %u ms, "
+                              "longest send gap %u ms.",
+                              ( unsigned int ) MQTT_KEEP_ALIVE_INTERVAL_SECONDS,
+                              ( unsigned int ) pingCount,
+                              ( unsigned int ) maxPingRoundTripMs,
+                              ( unsigned int ) maxTxGapMs );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the delay from the abrupt disconnect of a client to the
+ * delivery of its Last Will and Testament.
+ *
+ * The test context subscribes to TEST_MQTT_LWT_TOPIC. For each of the
+ * MQTT_BENCHMARK_LWT_ITERATIONS iterations, a client on
+ * pSecondNetworkContext connects with a QoS 0 will on that topic, carrying the
+ * iteration number, then its transport is disconnected without an MQTT
+ * DISCONNECT. The latency is measured with MQTT_BENCHMARK_GET_TIME_US() from
+ * the call to the network disconnect function to the receipt of the will by
+ * the test context, and includes the time the broker takes to detect the
+ * closed connection. The min, p50, p99, max and mean latencies are reported.
+ */
+TEST( MqttBenchmark, MQTT_LWT_Delivery_Latency )
+{
+    uint32_t latencyUs[ MQTT_BENCHMARK_LWT_ITERATIONS ];
+    MQTTPublishInfo_t willInfo = { 0 };
+    MQTTStatus_t xMQTTStatus;
+    uint64_t latencySumUs = 0U;
+    uint32_t sequence;
+    uint32_t disconnectTimeUs;
+    uint32_t receivedCount = 0U;
+    uint32_t entryTime;
+
+    /* Subscribe to the will topic. */
+    TEST_ASSERT_EQUAL( MQTTSuccess, subscribeToTopic( &context, TEST_MQTT_LWT_TOPIC, MQTTQoS0 ) );
+
+    entryTime = FRTest_GetTimeMs();
+
+    do
+    {
+        xMQTTStatus = MQTT_ProcessLoop( &context );
+
+        if( FRTest_GetTimeMs() > ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) )
+        {
+            /* Timeout. */
+            break;
+        }
+        else if( receivedSubAck != 0 )
+        {
+            break;
+        }
+        else
+        {
+            /* Nothing to do. */
+        }
+    } while( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) );
+
+    TEST_ASSERT_TRUE( receivedSubAck );
+    TEST_ASSERT_NOT_NULL( testParam.pSecondNetworkContext );
+
+    willInfo.qos = MQTTQoS0;
+    willInfo.pTopicName = TEST_MQTT_LWT_TOPIC;
+    willInfo.topicNameLength = TEST_MQTT_LWT_TOPIC_LENGTH;
+    willInfo.pPayload = &sequence;
+    willInfo.payloadLength = sizeof( sequence );
+
+    ( void ) memset( benchmarkClients, 0x00, sizeof( benchmarkClients ) );
+    benchmarkClients[ 1 ].pNetworkContext = testParam.pSecondNetworkContext;
+    ( void ) memset( &lwtBenchmark, 0x00, sizeof( lwtBenchmark ) );
+    benchmarkEventCallback = lwtEventCallback;
+
+    for( sequence = 0; sequence < MQTT_BENCHMARK_LWT_ITERATIONS; sequence++ )
+    {
+        lwtBenchmark.sequence = sequence;
+        lwtBenchmark.received = false;
+
+        connectBenchmarkClient( 1, benchmarkClientEventCallback, &willInfo );
+
+        /* Abruptly terminate the connection of the client. */
+        disconnectTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+        ( *testParam.pNetworkDisconnect )( benchmarkClients[ 1 ].pNetworkContext );
+        benchmarkClients[ 1 ].connected = false;
+
+        /* Allow some more time for the broker to realize the connection is
+         * closed. */
+        xMQTTStatus = MQTTSuccess;
+        entryTime = FRTest_GetTimeMs();
+
+        while( ( lwtBenchmark.received == false ) &&
+               ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+               ( FRTest_GetTimeMs() <= ( entryTime + ( MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS * 2U ) ) ) )
+        {
+            xMQTTStatus = MQTT_ProcessLoop( &context );
+        }
+
+        if( lwtBenchmark.received == false )
+        {
+            break;
+        }
+
+        latencyUs[ receivedCount ] = lwtBenchmark.receivedTimeUs - disconnectTimeUs;
+        latencySumUs += latencyUs[ receivedCount ];
+        receivedCount++;
+    }
+
+    benchmarkEventCallback = NULL;
+
+    TEST_ASSERT_TRUE_MESSAGE( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ),
+                              "MQTT_ProcessLoop failed while waiting for the will." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( MQTT_BENCHMARK_LWT_ITERATIONS, receivedCount,
+                                      "A will was not delivered in time." );
+
+    qsort( latencyUs, receivedCount, sizeof( uint32_t ), compareLatency );
+
+    printBenchmarkResult( "LWT delivery latency: %u wills, min %u us, p50 %u us, p99 %u us, max %u us, mean %u us, "
+                          "%u late wills.",
+                          ( unsigned int ) receivedCount,
+                          ( unsigned int ) latencyUs[ 0 ],
+                          ( unsigned int ) getLatencyPercentile( latencyUs, receivedCount, 50U ),
+                          ( unsigned int ) getLatencyPercentile( latencyUs, receivedCount, 99U ),
+                          ( unsigned int ) latencyUs[ receivedCount - 1U ],
+                          ( unsigned int ) ( latencySumUs / receivedCount ),
+                          ( unsigned int ) lwtBenchmark.staleCount );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measures the delivery of many retained messages to one wildcard
+ * subscription.
+ *
+ * MQTT_BENCHMARK_RETAINED_COUNT retained QoS 1 messages are published to
+ * topics under MQTT_BENCHMARK_RETAINED_TOPIC_PREFIX, then the test subscribes
+ * once to the wildcard topic filter matching all of them, as a device
+ * reconnecting with a wildcard subscription does. The time from sending the
+ * SUBSCRIBE to the SUBACK and to the last retained message is measured with
+ * MQTT_BENCHMARK_GET_TIME_US(). The largest number of bytes used in the network
+ * buffer and, when MQTT_BENCHMARK_GET_FREE_HEAP_SIZE() is defined, the peak
+ * heap usage of the platform during the delivery are reported. The wait for
+ * the messages times out after MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS without
+ * receiving one. The retained messages are cleared at the end of the test.
+ */
+TEST( MqttBenchmark, MQTT_Retained_Message_Storm )
+{
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+    uint32_t publishedCount = 0U;
+    uint32_t clearedCount = 0U;
+    uint32_t lastReceivedCount = 0U;
+    uint32_t subscribeTimeUs = 0U;
+    uint32_t deliveryUs;
+    uint32_t entryTime;
+    bool result = true;
+    size_t i;
+
+    #ifdef MQTT_BENCHMARK_GET_FREE_HEAP_SIZE
+        size_t initialFreeHeapSize;
+    #endif
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+    for( i = 0; i < MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE; i++ )
+    {
+        benchmarkPayload[ i ] = ( uint8_t ) i;
+    }
+
+    ( void ) memset( &retainedStorm, 0x00, sizeof( retainedStorm ) );
+    benchmarkEventCallback = retainedStormEventCallback;
+
+    while( ( result == true ) && ( publishedCount < MQTT_BENCHMARK_RETAINED_COUNT ) )
+    {
+        result = publishRetainedMessage( publishedCount, MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE );
+
+        if( result == true )
+        {
+            publishedCount++;
+        }
+    }
+
+    if( result == true )
+    {
+        #ifdef MQTT_BENCHMARK_GET_FREE_HEAP_SIZE
+            initialFreeHeapSize = MQTT_BENCHMARK_GET_FREE_HEAP_SIZE();
+            retainedStorm.minFreeHeapSize = initialFreeHeapSize;
+        #endif
+
+        context.transportInterface.recv = retainedStormRecv;
+        subscribeTimeUs = MQTT_BENCHMARK_GET_TIME_US();
+        xMQTTStatus = subscribeToTopic( &context, MQTT_BENCHMARK_RETAINED_TOPIC_FILTER, MQTTQoS1 );
+        entryTime = FRTest_GetTimeMs();
+
+        while( ( ( receivedSubAck == false ) || ( retainedStorm.receivedCount < publishedCount ) ) &&
+               ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+               ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+        {
+            xMQTTStatus = MQTT_ProcessLoop( &context );
+            sampleRetainedStormHeap();
+
+            /* The broker may take longer than one timeout to deliver all the
+             * messages, so only time out when none is received. */
+            if( retainedStorm.receivedCount != lastReceivedCount )
+            {
+                lastReceivedCount = retainedStorm.receivedCount;
+                entryTime = FRTest_GetTimeMs();
+            }
+        }
+
+        context.transportInterface.recv = MQTT_TEST_TRANSPORT_RECV;
+    }
+
+    /* Clear the retained messages, even if the benchmark failed, so that they
+     * are not delivered to the next tests. */
+    while( ( clearedCount < publishedCount ) && ( publishRetainedMessage( clearedCount, 0U ) == true ) )
+    {
+        clearedCount++;
+    }
+
+    benchmarkEventCallback = NULL;
+
+    TEST_ASSERT_TRUE_MESSAGE( result, "Publishing the retained messages failed." );
+    TEST_ASSERT_TRUE_MESSAGE( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ),
+                              "Receiving the retained messages failed." );
+    TEST_ASSERT_TRUE( receivedSubAck );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, retainedStorm.unexpectedCount, "Received unexpected retained messages." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, retainedStorm.duplicateCount, "Received retained messages twice." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( publishedCount, retainedStorm.receivedCount,
+                                      "Not every retained message was received." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( publishedCount, clearedCount, "Clearing the retained messages failed." );
+
+    deliveryUs = retainedStorm.lastMessageTimeUs - subscribeTimeUs;
+
+    printBenchmarkResult( "Retained message storm: %u retained messages of %u bytes, SUBACK in %u us, "
+                          "delivered in %u us, %u messages/s.",
+                          ( unsigned int ) publishedCount,
+                          ( unsigned int ) MQTT_BENCHMARK_RETAINED_PAYLOAD_SIZE,
+                          ( unsigned int ) ( retainedStorm.subAckTimeUs - subscribeTimeUs ),
+                          ( unsigned int ) deliveryUs,
+                          ( unsigned int ) getBenchmarkRate( publishedCount, deliveryUs, 1000000U ) );
+    printBenchmarkResult( "Retained message storm: peak network buffer usage %u of %u bytes.",
+                          ( unsigned int ) retainedStorm.peakBufferUsage,
+                          ( unsigned int ) context.networkBuffer.size );
+
+    #ifdef MQTT_BENCHMARK_GET_FREE_HEAP_SIZE
+        printBenchmarkResult( "Retained message storm: peak heap usage %u bytes.",
+                              ( unsigned int ) ( initialFreeHeapSize - retainedStorm.minFreeHeapSize ) );
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+#ifdef MQTT_BENCHMARK_BURST_TOPIC
+
+/**
+ * @brief Measures how many MQTT_ProcessLoop and transport recv calls are
+ * needed to drain small packets arriving back to back.
+ *
+ * For every count in MQTT_BENCHMARK_BURST_PACKET_COUNTS, the test publishes a
+ * request on MQTT_BENCHMARK_BURST_TOPIC, which the broker in tools/mqtt_broker
+ * answers with that many QoS 0 publishes of MQTT_BENCHMARK_BURST_PAYLOAD_SIZE
+ * bytes written at once, so that they share TCP segments and TLS records. The
+ * recv function of the port is wrapped to count the calls made by the MQTT
+ * library from the first byte of the burst. A port returning fewer bytes
+ * than requested by the library forces one recv call, or more, per packet.
+ * The time to drain the burst is measured with MQTT_BENCHMARK_GET_TIME_US().
+ */
+TEST( MqttBenchmark, MQTT_Coalesced_Packet_Receive )
+{
+    static const uint32_t packetCounts[] = MQTT_BENCHMARK_BURST_PACKET_COUNTS;
+    MQTTPublishInfo_t publishInfo = { 0 };
+    MQTTStatus_t xMQTTStatus = MQTTSuccess;
+    uint8_t request[ 4 ];
+    size_t remainingLength = 0U;
+    size_t packetSize = 0U;
+    size_t countIndex;
+    uint32_t packetCount = 0U;
+    uint32_t processLoopCount;
+    uint32_t entryTime;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( UINT16_MAX, MQTT_BENCHMARK_BURST_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_BURST_PAYLOAD_SIZE does not fit in a burst request." );
+
+    publishInfo.qos = MQTTQoS0;
+    publishInfo.pTopicName = MQTT_BENCHMARK_BURST_TOPIC;
+    publishInfo.topicNameLength = MQTT_BENCHMARK_BURST_TOPIC_LENGTH;
+    publishInfo.payloadLength = MQTT_BENCHMARK_BURST_PAYLOAD_SIZE;
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_GetPublishPacketSize( &publishInfo, &remainingLength, &packetSize ) );
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( MQTT_TEST_NETWORK_BUFFER_SIZE, packetSize,
+                                              "MQTT_BENCHMARK_BURST_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+
+    publishInfo.pPayload = request;
+    publishInfo.payloadLength = sizeof( request );
+
+    benchmarkEventCallback = coalescedReceiveEventCallback;
+    context.transportInterface.recv = countingRecv;
+
+    for( countIndex = 0; countIndex < ( sizeof( packetCounts ) / sizeof( packetCounts[ 0 ] ) ); countIndex++ )
+    {
+        packetCount = packetCounts[ countIndex ];
+
+        if( ( packetCount == 0U ) || ( packetCount > UINT16_MAX ) )
+        {
+            xMQTTStatus = MQTTBadParameter;
+            break;
+        }
+
+        ( void ) memset( &coalescedReceive, 0x00, sizeof( coalescedReceive ) );
+
+        request[ 0 ] = ( uint8_t ) ( packetCount >> 8 );
+        request[ 1 ] = ( uint8_t ) packetCount;
+        request[ 2 ] = ( uint8_t ) ( MQTT_BENCHMARK_BURST_PAYLOAD_SIZE >> 8 );
+        request[ 3 ] = ( uint8_t ) MQTT_BENCHMARK_BURST_PAYLOAD_SIZE;
+
+        xMQTTStatus = MQTT_Publish( &context, &publishInfo, 0U );
+
+        if( xMQTTStatus != MQTTSuccess )
+        {
+            break;
+        }
+
+        /* The calls before the first byte of the burst arrives are not
+         * counted. */
+        processLoopCount = 0U;
+        entryTime = FRTest_GetTimeMs();
+
+        while( ( coalescedReceive.receivedCount < packetCount ) &&
+               ( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ) ) &&
+               ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+        {
+            xMQTTStatus = MQTT_ProcessLoop( &context );
+
+            if( coalescedReceive.recvBytes > 0U )
+            {
+                processLoopCount++;
+            }
+        }
+
+        if( ( ( xMQTTStatus != MQTTSuccess ) && ( xMQTTStatus != MQTTNeedMoreBytes ) ) ||
+            ( coalescedReceive.receivedCount < packetCount ) ||
+            ( coalescedReceive.unexpectedCount > 0U ) )
+        {
+            break;
+        }
+
+        printBenchmarkResult( "Coalesced receive: %u packets of %u bytes, %u process loop calls, %u recv calls, "
+                              "%u with data, largest %u bytes, drained in %u us.",
+                              ( unsigned int ) packetCount,
+                              ( unsigned int ) packetSize,
+                              ( unsigned int ) processLoopCount,
+                              ( unsigned int ) coalescedReceive.recvCount,
+                              ( unsigned int ) coalescedReceive.dataRecvCount,
+                              ( unsigned int ) coalescedReceive.maxRecvBytes,
+                              ( unsigned int ) ( coalescedReceive.lastPacketTimeUs - coalescedReceive.firstDataTimeUs ) );
+    }
+
+    context.transportInterface.recv = MQTT_TEST_TRANSPORT_RECV;
+    benchmarkEventCallback = NULL;
+
+    TEST_ASSERT_NOT_EQUAL_MESSAGE( MQTTBadParameter, xMQTTStatus,
+                                   "MQTT_BENCHMARK_BURST_PACKET_COUNTS must be between 1 and 65535." );
+    TEST_ASSERT_TRUE_MESSAGE( ( xMQTTStatus == MQTTSuccess ) || ( xMQTTStatus == MQTTNeedMoreBytes ),
+                              "Publishing the burst request or receiving the burst failed." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, coalescedReceive.unexpectedCount,
+                                      "Received unexpected publishes, is the burst-topic of the broker set?" );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( packetCount, coalescedReceive.receivedCount,
+                                      "Not every publish of the burst was received." );
+}
+
+#endif /* ifdef MQTT_BENCHMARK_BURST_TOPIC */
+
+/*-----------------------------------------------------------*/
+
+#ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS
+
+/**
+ * @brief Measures publishing from several threads while a dedicated thread
+ * calls MQTT_ProcessLoop, and validates that the calls are thread safe when
+ * serialized with a mutex.
+ *
+ * A benchmark context connected on the network context of the test fixture
+ * subscribes to TEST_MQTT_TOPIC with QoS 1. A process loop thread then calls
+ * MQTT_ProcessLoop on it while MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT publisher
+ * threads each publish MQTT_BENCHMARK_PUBLISH_COUNT QoS 1 messages to the
+ * topic, as an application with a receive task does. Every call on the context is serialized with a
+ * mutex of the platform functions. Each message carries its publisher and
+ * sequence number, so the test fails if a message is corrupted, lost or
+ * reordered, or a PUBACK is missing. The throughput and, for the publishers
+ * and the process loop thread, the number of contended lock acquisitions and
+ * the time waiting for the mutex are reported.
+ */
+TEST( MqttBenchmark, MQTT_Process_Loop_Thread_Publishers )
+{
+    FRTestThreadHandle_t processLoopThreadHandle;
+    FRTestThreadHandle_t publisherThreadHandles[ MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT ] = { 0 };
+    BenchmarkLockStats_t publisherLockStats = { 0 };
+    MQTTSubscribeInfo_t subscription = { 0 };
+    uint32_t totalPublished = MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT * MQTT_BENCHMARK_PUBLISH_COUNT;
+    uint32_t windowFullCount = 0U;
+    uint32_t startTimeMs;
+    uint32_t elapsedMs;
+    uint32_t entryTime;
+    bool completed = false;
+    bool threadsCreated;
+    bool threadsExited = true;
+    size_t i;
+    size_t j;
+
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE( sizeof( benchmarkPayload ), MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE,
+                                              "MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE exceeds MQTT_TEST_NETWORK_BUFFER_SIZE." );
+    TEST_ASSERT_GREATER_OR_EQUAL_size_t_MESSAGE( MQTT_BENCHMARK_PUBLISHER_HEADER_SIZE, MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE,
+                                                 "MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE is too small." );
+
+    ( void ) memset( &processLoopThreadBenchmark, 0x00, sizeof( processLoopThreadBenchmark ) );
+
+    for( i = 0; i < MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT; i++ )
+    {
+        processLoopThreadBenchmark.publishers[ i ].payload[ 0 ] = ( uint8_t ) i;
+
+        for( j = MQTT_BENCHMARK_PUBLISHER_HEADER_SIZE; j < MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE; j++ )
+        {
+            processLoopThreadBenchmark.publishers[ i ].payload[ j ] = ( uint8_t ) ( j + i );
+        }
+    }
+
+    /* The threads share a context connected on the network context of the
+     * test fixture with the benchmark event callback, which does not assert. */
+    disconnectTestSession();
+    ( void ) memset( benchmarkClients, 0x00, sizeof( benchmarkClients ) );
+    benchmarkClients[ 0 ].pNetworkContext = testParam.pNetworkContext;
+    connectBenchmarkClient( 0, processLoopThreadEventCallback, NULL );
+    processLoopThreadBenchmark.pContext = benchmarkClients[ 0 ].pContext;
+
+    /* Subscribe with QoS 1 so that the messages are delivered back with the
+     * QoS they are published with. */
+    subscription.qos = MQTTQoS1;
+    subscription.pTopicFilter = TEST_MQTT_TOPIC;
+    subscription.topicFilterLength = TEST_MQTT_TOPIC_LENGTH;
+    TEST_ASSERT_EQUAL( MQTTSuccess, MQTT_Subscribe( processLoopThreadBenchmark.pContext,
+                                                    &subscription,
+                                                    1,
+                                                    MQTT_GetPacketId( processLoopThreadBenchmark.pContext ) ) );
+    TEST_ASSERT_TRUE( processBenchmarkClient( &benchmarkClients[ 0 ], &processLoopThreadBenchmark.subAckReceived ) );
+
+    processLoopThreadBenchmark.mutex = FRTest_MutexCreate();
+    TEST_ASSERT_MESSAGE( processLoopThreadBenchmark.mutex != NULL, "Create mutex failed." );
+
+    startTimeMs = FRTest_GetTimeMs();
+
+    processLoopThreadHandle = FRTest_ThreadCreate( processLoopThread, NULL );
+    i = 0;
+
+    while( ( processLoopThreadHandle != NULL ) && ( i < MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT ) )
+    {
+        publisherThreadHandles[ i ] = FRTest_ThreadCreate( publisherThread, &processLoopThreadBenchmark.publishers[ i ] );
+
+        if( publisherThreadHandles[ i ] == NULL )
+        {
+            break;
+        }
+
+        i++;
+    }
+
+    /* Stop every thread on a failure, and join them all before failing the
+     * test, so that no thread uses the context in the tear down. */
+    threadsCreated = ( i == MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT );
+
+    if( threadsCreated == false )
+    {
+        processLoopThreadBenchmark.stopFlag = true;
+    }
+
+    for( j = 0; j < i; j++ )
+    {
+        if( FRTest_ThreadTimedJoin( publisherThreadHandles[ j ], MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS ) != 0 )
+        {
+            /* Stop the threads and wait for the publisher again. */
+            processLoopThreadBenchmark.stopFlag = true;
+            threadsExited = false;
+            ( void ) FRTest_ThreadTimedJoin( publisherThreadHandles[ j ], MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS );
+        }
+    }
+
+    /* Wait for the remaining PUBACKs and messages. */
+    entryTime = FRTest_GetTimeMs();
+
+    while( ( processLoopThreadBenchmark.stopFlag == false ) && ( completed == false ) &&
+           ( FRTest_GetTimeMs() <= ( entryTime + MQTT_TEST_PROCESS_LOOP_TIMEOUT_MS ) ) )
+    {
+        FRTest_MutexLock( processLoopThreadBenchmark.mutex );
+        completed = ( processLoopThreadBenchmark.pubAckCount >= totalPublished ) &&
+                    ( processLoopThreadBenchmark.receivedCount >= totalPublished );
+        FRTest_MutexUnlock( processLoopThreadBenchmark.mutex );
+
+        if( completed == false )
+        {
+            FRTest_TimeDelay( 1U );
+        }
+    }
+
+    elapsedMs = FRTest_GetTimeMs() - startTimeMs;
+
+    processLoopThreadBenchmark.stopFlag = true;
+
+    if( ( processLoopThreadHandle != NULL ) &&
+        ( FRTest_ThreadTimedJoin( processLoopThreadHandle, MQTT_BENCHMARK_WAIT_THREAD_TIMEOUT_MS ) != 0 ) )
+    {
+        threadsExited = false;
+    }
+
+    /* The mutex is not deleted while a thread may still use it. */
+    if( threadsExited == true )
+    {
+        FRTest_MutexDelete( processLoopThreadBenchmark.mutex );
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE( threadsCreated, "Create thread failed." );
+    TEST_ASSERT_TRUE_MESSAGE( threadsExited, "Waiting for benchmark thread exit failed." );
+
+    for( i = 0; i < MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT; i++ )
+    {
+        TEST_ASSERT_TRUE_MESSAGE( processLoopThreadBenchmark.publishers[ i ].result, "Publisher thread failed." );
+
+        publisherLockStats.lockCount += processLoopThreadBenchmark.publishers[ i ].lockStats.lockCount;
+        publisherLockStats.contendedCount += processLoopThreadBenchmark.publishers[ i ].lockStats.contendedCount;
+        publisherLockStats.totalWaitUs += processLoopThreadBenchmark.publishers[ i ].lockStats.totalWaitUs;
+
+        if( processLoopThreadBenchmark.publishers[ i ].lockStats.maxWaitUs > publisherLockStats.maxWaitUs )
+        {
+            publisherLockStats.maxWaitUs = processLoopThreadBenchmark.publishers[ i ].lockStats.maxWaitUs;
+        }
+
+        windowFullCount += processLoopThreadBenchmark.publishers[ i ].windowFullCount;
+    }
+
+    TEST_ASSERT_TRUE_MESSAGE( ( processLoopThreadBenchmark.processLoopStatus == MQTTSuccess ) ||
+                              ( processLoopThreadBenchmark.processLoopStatus == MQTTNeedMoreBytes ),
+                              "MQTT_ProcessLoop failed in the process loop thread." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, processLoopThreadBenchmark.corruptedCount,
+                                      "Received corrupted messages." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( 0U, processLoopThreadBenchmark.outOfOrderCount,
+                                      "Received messages out of order." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( totalPublished, processLoopThreadBenchmark.pubAckCount,
+                                      "Not every publish was acknowledged." );
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE( totalPublished, processLoopThreadBenchmark.receivedCount,
+                                      "Not every message was received." );
+
+    printBenchmarkResult( "Process loop thread: %u publisher threads, %u byte payload, %u published, acknowledged "
+                          "and received in %u ms, %u messages/s, %u publishes retried.",
+                          ( unsigned int ) MQTT_BENCHMARK_PUBLISHER_THREAD_COUNT,
+                          ( unsigned int ) MQTT_BENCHMARK_PUBLISHER_PAYLOAD_SIZE,
+                          ( unsigned int ) totalPublished,
+                          ( unsigned int ) elapsedMs,
+                          ( unsigned int ) getBenchmarkRate( totalPublished, elapsedMs, MQTT_ONE_SECOND_TO_MS ),
+                          ( unsigned int ) windowFullCount );
+    printBenchmarkResult( "Process loop thread lock: publishers %u locks, %u contended, mean wait %u us, max %u us.",
+                          ( unsigned int ) publisherLockStats.lockCount,
+                          ( unsigned int ) publisherLockStats.contendedCount,
+                          ( unsigned int ) ( ( publisherLockStats.contendedCount > 0U ) ?
+                                             ( publisherLockStats.totalWaitUs / publisherLockStats.contendedCount ) : 0U ),
+                          ( unsigned int ) publisherLockStats.maxWaitUs );
+    printBenchmarkResult( "Process loop thread lock: process loop %u calls, %u contended, mean wait %u us, max %u us.",
+                          ( unsigned int ) processLoopThreadBenchmark.lockStats.lockCount,
+                          ( unsigned int ) processLoopThreadBenchmark.lockStats.contendedCount,
+                          ( unsigned int ) ( ( processLoopThreadBenchmark.lockStats.contendedCount > 0U ) ?
+                                             ( processLoopThreadBenchmark.lockStats.totalWaitUs /
+                                               processLoopThreadBenchmark.lockStats.contendedCount ) : 0U ),
+                          ( unsigned int ) processLoopThreadBenchmark.lockStats.maxWaitUs );
+}
+
+#endif /* ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Test group runner for MQTT benchmarks.
+ */
+TEST_GROUP_RUNNER( MqttBenchmark )
+{
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Publish_Throughput );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Publish_Receive_Latency );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Publish_Windowed_Throughput );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Qos2_Handshake );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Session_Restore_Pending_Publishes );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Subscription_Table );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Concurrent_Clients_Throughput );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Publish_Writev_Versus_Send );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Network_Buffer_Size );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Ping_Round_Trip );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Slow_Consumer_Backlog );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_Retained_Message_Storm );
+    RUN_TEST_CASE( MqttBenchmark, MQTT_LWT_Delivery_Latency );
+
+    #ifdef MQTT_BENCHMARK_BURST_TOPIC
+        RUN_TEST_CASE( MqttBenchmark, MQTT_Coalesced_Packet_Receive );
+    #endif
+
+    #ifdef MQTT_TEST_EXECUTE_PROCESS_LOOP_THREAD_TESTS
+        RUN_TEST_CASE( MqttBenchmark, MQTT_Process_Loop_Thread_Publishers );
+    #endif
+}
+
+/*-----------------------------------------------------------*/
+
+#endif /* ifdef MQTT_TEST_EXECUTE_BENCHMARK_TESTS */
+
+int RunMqttTest( void )
+{
+    int status = -1;
+
+    /* Calls user-implemented SetupMqttTestParam to fill in testParam */
+    SetupMqttTestParam( &testParam );
+    testHostInfo.pHostName = MQTT_SERVER_ENDPOINT;
+
+    #ifdef MQTT_TEST_TIME_WARP_FACTOR
+        warpBaseTimeMs = testParam.pGetTimeMs();
+    #endif
+    testHostInfo.port = MQTT_SERVER_PORT;
+
+    /* Initialize unity. */
+    UnityFixture.Verbose = 1;
+    UnityFixture.GroupFilter = 0;
+    UnityFixture.NameFilter = 0;
+    UnityFixture.RepeatCount = 1;
+
+    UNITY_BEGIN();
+
+    RUN_TEST_GROUP( MqttTest );
+
+    #ifdef MQTT_TEST_EXECUTE_BENCHMARK_TESTS
+        RUN_TEST_GROUP( MqttBenchmark );
+    #endif
 
     status = UNITY_END();
     return status;
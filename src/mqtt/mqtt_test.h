@@ -40,6 +40,8 @@ typedef struct MqttTestParam
     void * pNetworkContext;
     void * pSecondNetworkContext;
     MQTTGetCurrentTimeFunc_t pGetTimeMs; /**< @brief The getTimeFunction for MQTT_Init API. */
+    void ** pBenchmarkNetworkContexts;   /**< @brief Optional network contexts for the concurrent clients benchmark in addition to pNetworkContext and pSecondNetworkContext. */
+    size_t benchmarkNetworkContextCount; /**< @brief Number of network contexts in pBenchmarkNetworkContexts. */
 } MqttTestParam_t;
 
 /**
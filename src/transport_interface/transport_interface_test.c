@@ -31,6 +31,8 @@
 /* Standard header includes. */
 #include <string.h>
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
 
 /* Include for init and de-init functions. */
 #include "transport_interface_test.h"
@@ -150,6 +152,84 @@
     #define TEST_MESSAGE( x )    UnityPrint( x )
 #endif
 
+/**
+ * @brief Set to 1 when any of the optional benchmark tests is enabled.
+ */
+#if defined( TRANSPORT_TEST_EXECUTE_SESSION_RESUMPTION_TESTS ) || \
+    defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS ) ||       \
+    defined( TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS ) ||    \
+    defined( TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK )
+    #define TRANSPORT_TEST_BENCHMARK_ENABLED    ( 1 )
+#else
+    #define TRANSPORT_TEST_BENCHMARK_ENABLED    ( 0 )
+#endif
+
+/**
+ * @brief Length of the buffer used to format benchmark results.
+ */
+#define TRANSPORT_TEST_BENCHMARK_MESSAGE_LENGTH    ( 160U )
+
+/**
+ * @brief Number of connections made in the session resumption test.
+ *
+ * The first connection is expected to perform a full handshake. The remaining
+ * connections may resume the TLS session of the previous one.
+ */
+#ifndef TRANSPORT_TEST_SESSION_RESUMPTION_ITERATIONS
+    #define TRANSPORT_TEST_SESSION_RESUMPTION_ITERATIONS    ( 5U )
+#endif
+
+/**
+ * @brief Size of the data echoed over each connection in the session resumption test.
+ */
+#define TRANSPORT_TEST_SESSION_RESUMPTION_ECHO_LENGTH    ( 64U )
+
+/**
+ * @brief Size of the data echoed over each connection in the cipher suite benchmark.
+ *
+ * The data is echoed in chunks of TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH bytes.
+ */
+#ifndef TRANSPORT_TEST_CIPHER_SUITE_BULK_LENGTH
+    #define TRANSPORT_TEST_CIPHER_SUITE_BULK_LENGTH    ( 65536U )
+#endif
+
+/**
+ * @brief Number of TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH byte echoes in the fragmented receive test.
+ */
+#ifndef TRANSPORT_TEST_FRAGMENTED_RECV_ITERATIONS
+    #define TRANSPORT_TEST_FRAGMENTED_RECV_ITERATIONS    ( 10U )
+#endif
+
+/**
+ * @brief Number of frames sent with each method in the writev benchmark.
+ */
+#ifndef TRANSPORT_TEST_WRITEV_BENCHMARK_FRAME_COUNT
+    #define TRANSPORT_TEST_WRITEV_BENCHMARK_FRAME_COUNT    ( 1000U )
+#endif
+
+/**
+ * @brief Payload length of the frames sent in the writev benchmark.
+ */
+#ifndef TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH
+    #define TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH    ( 256U )
+#endif
+
+/**
+ * @brief Timestamp in microseconds used to measure the time spent sending in
+ * the writev benchmark.
+ *
+ * The default has the resolution of FRTest_GetTimeMs(). Define it to read a
+ * high resolution timer or a CPU cycle counter scaled to microseconds.
+ */
+#ifndef TRANSPORT_TEST_GET_TIME_US
+    #define TRANSPORT_TEST_GET_TIME_US()    ( FRTest_GetTimeMs() * 1000U )
+#endif
+
+/**
+ * @brief Topic of the MQTT PUBLISH like frames sent in the writev benchmark.
+ */
+#define TRANSPORT_TEST_WRITEV_BENCHMARK_TOPIC    "benchmark/writev"
+
 /*-----------------------------------------------------------*/
 
 typedef struct threadParameter
@@ -161,6 +241,19 @@ typedef struct threadParameter
     bool xResult;
 } threadParameter_t;
 
+#ifdef TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS
+
+/**
+ * @brief An echo server port which serves a single cipher suite.
+ */
+typedef struct cipherSuiteEndpoint
+{
+    const char * pCipherSuiteName; /**< @brief Name of the cipher suite reported in the results. */
+    uint16_t port;                 /**< @brief Echo server port serving the cipher suite. */
+} cipherSuiteEndpoint_t;
+
+#endif /* ifdef TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS */
+
 /*-----------------------------------------------------------*/
 
 #if ( TRANSPORT_INTERFACE_TEST_ENABLED == 1 )
@@ -171,6 +264,18 @@ typedef struct threadParameter
     #ifndef ECHO_SERVER_PORT
         #error "Please define ECHO_SERVER_PORT"
     #endif
+
+    #if defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS ) && !defined( TRANSPORT_TEST_CIPHER_SUITE_ENDPOINTS )
+        #error "Please define TRANSPORT_TEST_CIPHER_SUITE_ENDPOINTS"
+    #endif
+
+    #if defined( TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS ) && !defined( TRANSPORT_TEST_FRAGMENTED_ECHO_SERVER_PORT )
+        #error "Please define TRANSPORT_TEST_FRAGMENTED_ECHO_SERVER_PORT"
+    #endif
+
+    #if defined( TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK ) && !defined( TRANSPORT_TEST_EXECUTE_WRITEV_TESTS )
+        #error "Please define TRANSPORT_TEST_EXECUTE_WRITEV_TESTS to run the writev benchmark"
+    #endif
 #endif /* if ( TRANSPORT_INTERFACE_TEST_ENABLED == 1 ) */
 
 /*-----------------------------------------------------------*/
@@ -487,6 +592,244 @@ static bool prvTransportRecvData( TransportInterface_t * pTransport,
 
 /*-----------------------------------------------------------*/
 
+#if ( TRANSPORT_TEST_BENCHMARK_ENABLED == 1 )
+
+/**
+ * @brief Format a benchmark result and print it with the Unity output.
+ */
+static void prvPrintBenchmarkResult( const char * pFormat,
+                                     ... )
+{
+    char message[ TRANSPORT_TEST_BENCHMARK_MESSAGE_LENGTH ];
+    va_list args;
+
+    va_start( args, pFormat );
+    ( void ) vsnprintf( message, sizeof( message ), pFormat, args );
+    va_end( args );
+
+    TEST_MESSAGE( message );
+}
+
+    #if defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS ) || defined( TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK )
+
+/**
+ * @brief Number of bytes per second transferred in elapsedMs. A time of 0
+ * measured with a coarse timer is counted as 1 ms.
+ */
+static uint64_t prvGetBenchmarkRate( uint64_t byteCount,
+                                     uint32_t elapsedMs )
+{
+    return ( byteCount * 1000U ) / ( ( elapsedMs == 0U ) ? 1U : elapsedMs );
+}
+
+    #endif /* if defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS ) || defined( TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK ) */
+
+#endif /* if ( TRANSPORT_TEST_BENCHMARK_ENABLED == 1 ) */
+
+/*-----------------------------------------------------------*/
+
+#if defined( TRANSPORT_TEST_EXECUTE_SESSION_RESUMPTION_TESTS ) || defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS )
+
+/**
+ * @brief Connect the network context and measure the time taken by the connect hook.
+ *
+ * The measured time includes the TCP connection and, for a TLS transport, the
+ * TLS handshake.
+ */
+static NetworkConnectStatus_t prvTimedNetworkConnect( NetworkContext_t * pNetworkContext,
+                                                      TestHostInfo_t * pHostInfo,
+                                                      uint32_t * pElapsedMs )
+{
+    NetworkConnectStatus_t networkConnectResult;
+    uint32_t startTimeMs;
+
+    startTimeMs = FRTest_GetTimeMs();
+    networkConnectResult = testParam.pNetworkConnect( pNetworkContext, pHostInfo,
+                                                      testParam.pNetworkCredentials );
+    *pElapsedMs = FRTest_GetTimeMs() - startTimeMs;
+
+    return networkConnectResult;
+}
+
+#endif /* if defined( TRANSPORT_TEST_EXECUTE_SESSION_RESUMPTION_TESTS ) || defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS ) */
+
+/*-----------------------------------------------------------*/
+
+#if defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS ) || defined( TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS ) || \
+    defined( TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK )
+
+/**
+ * @brief Receive the data from transport network without delay between retries.
+ *
+ * prvTransportRecvData delays between partial receives, which would dominate
+ * the measured time. This function calls the receive API until all the data is
+ * received, or fails if no data is received for TRANSPORT_TEST_NETWORK_DELAY_MS.
+ * The number of receive calls which returned data is added to pRecvCallCount
+ * when it is not NULL.
+ */
+static bool prvBenchmarkRecvData( NetworkContext_t * pNetworkContext,
+                                  uint8_t * pTransportTestBuffer,
+                                  uint32_t recvSize,
+                                  uint32_t * pRecvCallCount )
+{
+    uint32_t transferTotal = 0U;
+    int32_t transportResult = 0;
+    uint32_t lastReceiveTimeMs = FRTest_GetTimeMs();
+    bool retValue = true;
+
+    while( transferTotal < recvSize )
+    {
+        transportResult = pTestTransport->recv( pNetworkContext,
+                                                &pTransportTestBuffer[ transferTotal ],
+                                                recvSize - transferTotal );
+
+        if( ( transportResult < 0 ) || ( ( recvSize - transferTotal ) < ( uint32_t ) transportResult ) )
+        {
+            TEST_MESSAGE( "Transport receive data should not have any error." );
+            retValue = false;
+            break;
+        }
+        else if( transportResult > 0 )
+        {
+            transferTotal = transferTotal + ( uint32_t ) transportResult;
+            lastReceiveTimeMs = FRTest_GetTimeMs();
+
+            if( pRecvCallCount != NULL )
+            {
+                ( *pRecvCallCount )++;
+            }
+        }
+        else if( ( FRTest_GetTimeMs() - lastReceiveTimeMs ) > TRANSPORT_TEST_NETWORK_DELAY_MS )
+        {
+            TEST_MESSAGE( "Fail to receive all the data expected." );
+            retValue = false;
+            break;
+        }
+        else
+        {
+            /* Empty else. Retry the receive. */
+        }
+    }
+
+    return retValue;
+}
+
+#endif /* if defined( TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS ) || defined( TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS ) || defined( TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK ) */
+
+/*-----------------------------------------------------------*/
+
+#ifdef TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS
+
+/**
+ * @brief Echo bulk data through the echo server and measure the time taken.
+ *
+ * The data is sent in chunks of TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH bytes and
+ * each chunk is received before the next one is sent. Each chunk is received
+ * into a buffer filled with TRANSPORT_TEST_BUFFER_GUARD_PATTERN and verified
+ * before the next one is sent. Only the send and receive time is measured.
+ */
+static bool prvBenchmarkEchoData( NetworkContext_t * pNetworkContext,
+                                  uint8_t * pTransportTestBuffer,
+                                  uint32_t totalSize,
+                                  uint32_t * pElapsedMs )
+{
+    uint32_t transferTotal = 0U;
+    uint32_t chunkSize = 0U;
+    uint32_t startTimeMs;
+    bool retValue = true;
+
+    *pElapsedMs = 0U;
+
+    while( ( retValue == true ) && ( transferTotal < totalSize ) )
+    {
+        chunkSize = totalSize - transferTotal;
+
+        if( chunkSize > TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH )
+        {
+            chunkSize = TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH;
+        }
+
+        prvInitializeTestData( pTransportTestBuffer, chunkSize );
+
+        startTimeMs = FRTest_GetTimeMs();
+        retValue = prvTransportSendData( pTestTransport, pNetworkContext, pTransportTestBuffer, chunkSize );
+        *pElapsedMs += FRTest_GetTimeMs() - startTimeMs;
+
+        if( retValue == true )
+        {
+            memset( pTransportTestBuffer, TRANSPORT_TEST_BUFFER_GUARD_PATTERN, TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH );
+
+            startTimeMs = FRTest_GetTimeMs();
+            retValue = prvBenchmarkRecvData( pNetworkContext, pTransportTestBuffer, chunkSize, NULL );
+            *pElapsedMs += FRTest_GetTimeMs() - startTimeMs;
+        }
+
+        if( retValue == true )
+        {
+            retValue = prvVerifyTestData( pTransportTestBuffer, chunkSize, TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH );
+        }
+
+        transferTotal = transferTotal + chunkSize;
+    }
+
+    return retValue;
+}
+
+#endif /* ifdef TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS */
+
+/*-----------------------------------------------------------*/
+
+#ifdef TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS
+
+/**
+ * @brief Echo TRANSPORT_TEST_FRAGMENTED_RECV_ITERATIONS buffers and measure their reception.
+ *
+ * Only the time spent receiving is measured. The number of receive calls which
+ * returned data is reported in pRecvCallCount.
+ */
+static bool prvMeasureRecvCalls( NetworkContext_t * pNetworkContext,
+                                 uint8_t * pTransportTestBuffer,
+                                 uint32_t * pRecvCallCount,
+                                 uint32_t * pRecvTimeMs )
+{
+    uint32_t iteration;
+    uint32_t startTimeMs;
+    bool retValue = true;
+
+    *pRecvCallCount = 0U;
+    *pRecvTimeMs = 0U;
+
+    for( iteration = 0U; ( retValue == true ) && ( iteration < TRANSPORT_TEST_FRAGMENTED_RECV_ITERATIONS ); iteration++ )
+    {
+        prvInitializeTestData( pTransportTestBuffer, TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH );
+
+        retValue = prvTransportSendData( pTestTransport, pNetworkContext, pTransportTestBuffer,
+                                         TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH );
+
+        if( retValue == true )
+        {
+            memset( pTransportTestBuffer, TRANSPORT_TEST_BUFFER_GUARD_PATTERN, TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH );
+
+            startTimeMs = FRTest_GetTimeMs();
+            retValue = prvBenchmarkRecvData( pNetworkContext, pTransportTestBuffer,
+                                             TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH, pRecvCallCount );
+            *pRecvTimeMs += FRTest_GetTimeMs() - startTimeMs;
+        }
+
+        if( retValue == true )
+        {
+            retValue = prvVerifyTestData( pTransportTestBuffer, TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH,
+                                          TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH );
+        }
+    }
+
+    return retValue;
+}
+
+#endif /* ifdef TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS */
+
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Verify the buffer guard of the test buffer.
  */
@@ -793,6 +1136,13 @@ TEST_TEAR_DOWN( Full_TransportInterfaceTest )
         testParam.pNetworkDisconnect( pNetworkContext );
         threadParameter[ TRANSPORT_TEST_INDEX ].xNetworkConnected = false;
     }
+
+    /* The secondary network context may be left connected by a failed test. */
+    if( threadParameter[ TRANSPORT_TEST_SECOND_INDEX ].xNetworkConnected == true )
+    {
+        testParam.pNetworkDisconnect( threadParameter[ TRANSPORT_TEST_SECOND_INDEX ].pNetworkContext );
+        threadParameter[ TRANSPORT_TEST_SECOND_INDEX ].xNetworkConnected = false;
+    }
 }
 
 /*-----------------------------------------------------------*/
@@ -1243,6 +1593,241 @@ TEST( Full_TransportInterfaceTest, TransportRecv_ReturnZeroRetry )
     TEST_ASSERT_MESSAGE( timedWaitResult == 0, "Waiting for test thread receive data failed." );
 }
 
+/*-----------------------------------------------------------*/
+
+#ifdef TRANSPORT_TEST_EXECUTE_SESSION_RESUMPTION_TESTS
+
+/**
+ * @brief Test transport interface reconnection with TLS session resumption.
+ *
+ * The secondary network context is connected, used to echo some data and
+ * disconnected TRANSPORT_TEST_SESSION_RESUMPTION_ITERATIONS times. The first
+ * connection performs a full handshake. A transport implementation which keeps
+ * the TLS session of the previous connection resumes it with an abbreviated
+ * handshake on the following connections. The connect time of the first
+ * connection and of the reconnections are reported for comparison. Whether the
+ * session was actually resumed is logged by the echo server.
+ */
+TEST( Full_TransportInterfaceTest, Transport_ReconnectSessionResumption )
+{
+    NetworkConnectStatus_t networkConnectResult = NETWORK_CONNECT_SUCCESS;
+    threadParameter_t * pThreadParameter = &threadParameter[ TRANSPORT_TEST_SECOND_INDEX ];
+    uint8_t * pTransportTestBufferStart =
+        &( pThreadParameter->transportTestBuffer[ TRANSPORT_TEST_BUFFER_PREFIX_GUARD_LENGTH ] );
+    uint32_t connectTimeMs = 0U;
+    uint32_t fullConnectTimeMs = 0U;
+    uint32_t reconnectTimeTotalMs = 0U;
+    uint32_t reconnectTimeMinMs = UINT32_MAX;
+    uint32_t reconnectTimeMaxMs = 0U;
+    uint32_t iteration;
+    bool retValue;
+
+    TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE( 1U, TRANSPORT_TEST_SESSION_RESUMPTION_ITERATIONS,
+                                             "At least one reconnection is required." );
+
+    memset( pThreadParameter->transportTestBuffer, TRANSPORT_TEST_BUFFER_GUARD_PATTERN,
+            TRANSPORT_TEST_BUFFER_TOTAL_LENGTH );
+
+    for( iteration = 0U; iteration < TRANSPORT_TEST_SESSION_RESUMPTION_ITERATIONS; iteration++ )
+    {
+        networkConnectResult = prvTimedNetworkConnect( pThreadParameter->pNetworkContext,
+                                                       &testHostInfo, &connectTimeMs );
+        TEST_ASSERT_EQUAL_INT32_MESSAGE( NETWORK_CONNECT_SUCCESS, networkConnectResult, "Network connect failed." );
+        pThreadParameter->xNetworkConnected = true;
+
+        if( iteration == 0U )
+        {
+            fullConnectTimeMs = connectTimeMs;
+        }
+        else
+        {
+            reconnectTimeTotalMs += connectTimeMs;
+            reconnectTimeMinMs = ( connectTimeMs < reconnectTimeMinMs ) ? connectTimeMs : reconnectTimeMinMs;
+            reconnectTimeMaxMs = ( connectTimeMs > reconnectTimeMaxMs ) ? connectTimeMs : reconnectTimeMaxMs;
+        }
+
+        /* The resumed session must be usable for sending and receiving data. */
+        prvInitializeTestData( pTransportTestBufferStart, TRANSPORT_TEST_SESSION_RESUMPTION_ECHO_LENGTH );
+
+        retValue = prvTransportSendData( pTestTransport, pThreadParameter->pNetworkContext,
+                                         pTransportTestBufferStart, TRANSPORT_TEST_SESSION_RESUMPTION_ECHO_LENGTH );
+        TEST_ASSERT_MESSAGE( ( retValue == true ), "Send test data failed." );
+
+        retValue = prvTransportRecvData( pTestTransport, pThreadParameter->pNetworkContext,
+                                         pTransportTestBufferStart, TRANSPORT_TEST_SESSION_RESUMPTION_ECHO_LENGTH );
+        TEST_ASSERT_MESSAGE( ( retValue == true ), "Receive test data failed." );
+
+        retValue = prvVerifyTestData( pTransportTestBufferStart, TRANSPORT_TEST_SESSION_RESUMPTION_ECHO_LENGTH,
+                                      TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH );
+        TEST_ASSERT_MESSAGE( ( retValue == true ), "Verify test data failed." );
+
+        testParam.pNetworkDisconnect( pThreadParameter->pNetworkContext );
+        pThreadParameter->xNetworkConnected = false;
+    }
+
+    prvVerifyTestBufferGuard( pThreadParameter->transportTestBuffer );
+
+    prvPrintBenchmarkResult( "Session resumption: first connect %u ms, reconnect average %u ms, "
+                             "min %u ms, max %u ms over %u reconnections.",
+                             ( unsigned int ) fullConnectTimeMs,
+                             ( unsigned int ) ( reconnectTimeTotalMs / ( TRANSPORT_TEST_SESSION_RESUMPTION_ITERATIONS - 1U ) ),
+                             ( unsigned int ) reconnectTimeMinMs,
+                             ( unsigned int ) reconnectTimeMaxMs,
+                             ( unsigned int ) ( TRANSPORT_TEST_SESSION_RESUMPTION_ITERATIONS - 1U ) );
+}
+
+#endif /* ifdef TRANSPORT_TEST_EXECUTE_SESSION_RESUMPTION_TESTS */
+
+/*-----------------------------------------------------------*/
+
+#ifdef TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS
+
+/**
+ * @brief Benchmark the cipher suites served by the echo server.
+ *
+ * The echo server serves one cipher suite per port when the
+ * "cipher-suite-per-port" option is enabled. For every endpoint in
+ * TRANSPORT_TEST_CIPHER_SUITE_ENDPOINTS, the secondary network context is
+ * connected, TRANSPORT_TEST_CIPHER_SUITE_BULK_LENGTH bytes are echoed and the
+ * connection is closed. The handshake time and echo throughput of each cipher
+ * suite are reported. A cipher suite which the device fails to negotiate is
+ * reported and skipped.
+ */
+TEST( Full_TransportInterfaceTest, Transport_CipherSuiteBenchmark )
+{
+    static const cipherSuiteEndpoint_t cipherSuiteEndpoints[] = TRANSPORT_TEST_CIPHER_SUITE_ENDPOINTS;
+    NetworkConnectStatus_t networkConnectResult = NETWORK_CONNECT_SUCCESS;
+    threadParameter_t * pThreadParameter = &threadParameter[ TRANSPORT_TEST_SECOND_INDEX ];
+    uint8_t * pTransportTestBufferStart =
+        &( pThreadParameter->transportTestBuffer[ TRANSPORT_TEST_BUFFER_PREFIX_GUARD_LENGTH ] );
+    TestHostInfo_t cipherSuiteHostInfo = { 0 };
+    uint32_t handshakeTimeMs = 0U;
+    uint32_t echoTimeMs = 0U;
+    uint32_t endpointIndex;
+    uint32_t cipherSuitesMeasured = 0U;
+    bool retValue;
+
+    memset( pThreadParameter->transportTestBuffer, TRANSPORT_TEST_BUFFER_GUARD_PATTERN,
+            TRANSPORT_TEST_BUFFER_TOTAL_LENGTH );
+
+    cipherSuiteHostInfo.pHostName = ECHO_SERVER_ENDPOINT;
+
+    for( endpointIndex = 0U;
+         endpointIndex < ( sizeof( cipherSuiteEndpoints ) / sizeof( cipherSuiteEndpoints[ 0 ] ) );
+         endpointIndex++ )
+    {
+        cipherSuiteHostInfo.port = cipherSuiteEndpoints[ endpointIndex ].port;
+
+        networkConnectResult = prvTimedNetworkConnect( pThreadParameter->pNetworkContext,
+                                                       &cipherSuiteHostInfo, &handshakeTimeMs );
+
+        if( networkConnectResult != NETWORK_CONNECT_SUCCESS )
+        {
+            prvPrintBenchmarkResult( "Cipher suite %s (port %u): network connect failed.",
+                                     cipherSuiteEndpoints[ endpointIndex ].pCipherSuiteName,
+                                     ( unsigned int ) cipherSuiteHostInfo.port );
+            continue;
+        }
+
+        pThreadParameter->xNetworkConnected = true;
+
+        retValue = prvBenchmarkEchoData( pThreadParameter->pNetworkContext, pTransportTestBufferStart,
+                                         TRANSPORT_TEST_CIPHER_SUITE_BULK_LENGTH, &echoTimeMs );
+
+        testParam.pNetworkDisconnect( pThreadParameter->pNetworkContext );
+        pThreadParameter->xNetworkConnected = false;
+
+        if( retValue == true )
+        {
+            prvPrintBenchmarkResult( "Cipher suite %s (port %u): handshake %u ms, echo throughput %lu bytes/s.",
+                                     cipherSuiteEndpoints[ endpointIndex ].pCipherSuiteName,
+                                     ( unsigned int ) cipherSuiteHostInfo.port,
+                                     ( unsigned int ) handshakeTimeMs,
+                                     ( unsigned long ) prvGetBenchmarkRate( TRANSPORT_TEST_CIPHER_SUITE_BULK_LENGTH, echoTimeMs ) );
+            cipherSuitesMeasured++;
+        }
+        else
+        {
+            prvPrintBenchmarkResult( "Cipher suite %s (port %u): echo failed.",
+                                     cipherSuiteEndpoints[ endpointIndex ].pCipherSuiteName,
+                                     ( unsigned int ) cipherSuiteHostInfo.port );
+        }
+    }
+
+    prvVerifyTestBufferGuard( pThreadParameter->transportTestBuffer );
+
+    TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE( 0U, cipherSuitesMeasured, "No cipher suite could be benchmarked." );
+}
+
+#endif /* ifdef TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS */
+
+/*-----------------------------------------------------------*/
+
+#ifdef TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS
+
+/**
+ * @brief Test transport interface receive with replies split in many small pieces.
+ *
+ * The echo server on TRANSPORT_TEST_FRAGMENTED_ECHO_SERVER_PORT splits every
+ * echo into randomly sized writes, each sent in its own TCP segment or TLS
+ * record. The data echoed must be reassembled correctly by the receive
+ * function. The number of receive calls and the time spent receiving are
+ * reported and compared with the same echoes from the echo server on
+ * ECHO_SERVER_PORT, which replies in one piece.
+ */
+TEST( Full_TransportInterfaceTest, Transport_FragmentedRecv )
+{
+    NetworkConnectStatus_t networkConnectResult = NETWORK_CONNECT_SUCCESS;
+    threadParameter_t * pThreadParameter = &threadParameter[ TRANSPORT_TEST_SECOND_INDEX ];
+    uint8_t * pTransportTestBufferStart =
+        &( pThreadParameter->transportTestBuffer[ TRANSPORT_TEST_BUFFER_PREFIX_GUARD_LENGTH ] );
+    TestHostInfo_t fragmentedHostInfo = { 0 };
+    uint32_t recvCallCount = 0U;
+    uint32_t recvTimeMs = 0U;
+    uint32_t fragmentedRecvCallCount = 0U;
+    uint32_t fragmentedRecvTimeMs = 0U;
+    bool retValue;
+
+    memset( pThreadParameter->transportTestBuffer, TRANSPORT_TEST_BUFFER_GUARD_PATTERN,
+            TRANSPORT_TEST_BUFFER_TOTAL_LENGTH );
+
+    /* Echo with the primary network context connected in the test setup. */
+    retValue = prvMeasureRecvCalls( threadParameter[ TRANSPORT_TEST_INDEX ].pNetworkContext,
+                                    &( threadParameter[ TRANSPORT_TEST_INDEX ].transportTestBuffer[ TRANSPORT_TEST_BUFFER_PREFIX_GUARD_LENGTH ] ),
+                                    &recvCallCount, &recvTimeMs );
+    TEST_ASSERT_MESSAGE( ( retValue == true ), "Echo from the echo server failed." );
+
+    /* Echo from the echo server which fragments its replies. */
+    fragmentedHostInfo.pHostName = ECHO_SERVER_ENDPOINT;
+    fragmentedHostInfo.port = TRANSPORT_TEST_FRAGMENTED_ECHO_SERVER_PORT;
+
+    networkConnectResult = testParam.pNetworkConnect( pThreadParameter->pNetworkContext,
+                                                      &fragmentedHostInfo, testParam.pNetworkCredentials );
+    TEST_ASSERT_EQUAL_INT32_MESSAGE( NETWORK_CONNECT_SUCCESS, networkConnectResult, "Network connect failed." );
+    pThreadParameter->xNetworkConnected = true;
+
+    retValue = prvMeasureRecvCalls( pThreadParameter->pNetworkContext, pTransportTestBufferStart,
+                                    &fragmentedRecvCallCount, &fragmentedRecvTimeMs );
+    TEST_ASSERT_MESSAGE( ( retValue == true ), "Echo from the fragmenting echo server failed." );
+
+    testParam.pNetworkDisconnect( pThreadParameter->pNetworkContext );
+    pThreadParameter->xNetworkConnected = false;
+
+    prvVerifyTestBufferGuard( pThreadParameter->transportTestBuffer );
+
+    prvPrintBenchmarkResult( "Unfragmented recv: %u bytes in %u calls, %u ms.",
+                             ( unsigned int ) ( TRANSPORT_TEST_FRAGMENTED_RECV_ITERATIONS * TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH ),
+                             ( unsigned int ) recvCallCount,
+                             ( unsigned int ) recvTimeMs );
+    prvPrintBenchmarkResult( "Fragmented recv: %u bytes in %u calls, %u ms, %u us per call.",
+                             ( unsigned int ) ( TRANSPORT_TEST_FRAGMENTED_RECV_ITERATIONS * TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH ),
+                             ( unsigned int ) fragmentedRecvCallCount,
+                             ( unsigned int ) fragmentedRecvTimeMs,
+                             ( unsigned int ) ( ( fragmentedRecvTimeMs * 1000U ) / fragmentedRecvCallCount ) );
+}
+
+#endif /* ifdef TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS */
+
 /*-----------------------------------------------------------*/
 #ifdef TRANSPORT_TEST_EXECUTE_WRITEV_TESTS
 /**
@@ -1607,6 +2192,189 @@ TEST( Full_TransportInterfaceTest, TransportWritev_RemoteDisconnect )
                                          "Transport writev should return negative value when disconnected." );
 }
 
+#ifdef TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send MQTT PUBLISH like frames through the echo server with writev or
+ * with a copy into one buffer followed by send.
+ *
+ * Each frame is made of a fixed header, a topic and a payload vector. The
+ * frames are sent in batches that fit in the test buffer and each batch is
+ * received back before the next one is sent. The time spent in the send path,
+ * including the copy, is added to pSendTimeUs.
+ */
+static bool prvBenchmarkFramedSend( NetworkContext_t * pNetworkContext,
+                                    uint8_t * pTransportTestBuffer,
+                                    bool useWritev,
+                                    uint32_t * pElapsedMs,
+                                    uint32_t * pSendTimeUs )
+{
+    static uint8_t payload[ TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH ];
+    static uint8_t copyBuffer[ TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH ];
+    uint8_t fixedHeader[ 5 ];
+    uint8_t topic[ sizeof( TRANSPORT_TEST_WRITEV_BENCHMARK_TOPIC ) + 1U ];
+    TransportOutVector_t vectors[ 3 ];
+    uint8_t * pFrame;
+    size_t fixedHeaderLength = 1U;
+    size_t topicLength = sizeof( TRANSPORT_TEST_WRITEV_BENCHMARK_TOPIC ) + 1U;
+    size_t remainingLength = topicLength + TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH;
+    size_t frameLength;
+    uint32_t framesPerBatch;
+    uint32_t framesSent = 0U;
+    uint32_t batchFrames;
+    uint32_t frame;
+    uint32_t startTimeMs;
+    uint32_t startTimeUs;
+    uint32_t i;
+    bool retValue = true;
+
+    /* Encode the frame like an MQTT PUBLISH packet. */
+    fixedHeader[ 0 ] = 0x30U;
+
+    do
+    {
+        fixedHeader[ fixedHeaderLength ] = ( uint8_t ) ( remainingLength & 0x7FU );
+        remainingLength >>= 7;
+
+        if( remainingLength > 0U )
+        {
+            fixedHeader[ fixedHeaderLength ] |= 0x80U;
+        }
+
+        fixedHeaderLength++;
+    } while( remainingLength > 0U );
+
+    topic[ 0 ] = 0U;
+    topic[ 1 ] = ( uint8_t ) ( sizeof( TRANSPORT_TEST_WRITEV_BENCHMARK_TOPIC ) - 1U );
+    memcpy( &topic[ 2 ], TRANSPORT_TEST_WRITEV_BENCHMARK_TOPIC, sizeof( TRANSPORT_TEST_WRITEV_BENCHMARK_TOPIC ) - 1U );
+
+    for( i = 0U; i < TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH; i++ )
+    {
+        payload[ i ] = ( uint8_t ) i;
+    }
+
+    frameLength = fixedHeaderLength + topicLength + TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH;
+    framesPerBatch = ( uint32_t ) ( TRANSPORT_TEST_BUFFER_WRITABLE_LENGTH / frameLength );
+    TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE( 0U, framesPerBatch,
+                                             "TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH exceeds the test buffer." );
+
+    *pSendTimeUs = 0U;
+    startTimeMs = FRTest_GetTimeMs();
+
+    while( ( retValue == true ) && ( framesSent < TRANSPORT_TEST_WRITEV_BENCHMARK_FRAME_COUNT ) )
+    {
+        batchFrames = TRANSPORT_TEST_WRITEV_BENCHMARK_FRAME_COUNT - framesSent;
+
+        if( batchFrames > framesPerBatch )
+        {
+            batchFrames = framesPerBatch;
+        }
+
+        for( frame = 0U; ( retValue == true ) && ( frame < batchFrames ); frame++ )
+        {
+            startTimeUs = TRANSPORT_TEST_GET_TIME_US();
+
+            if( useWritev == true )
+            {
+                /* The vectors are updated on partial writes. */
+                vectors[ 0 ].iov_base = fixedHeader;
+                vectors[ 0 ].iov_len = fixedHeaderLength;
+                vectors[ 1 ].iov_base = topic;
+                vectors[ 1 ].iov_len = topicLength;
+                vectors[ 2 ].iov_base = payload;
+                vectors[ 2 ].iov_len = TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH;
+
+                retValue = prvTransportWritevData( pTestTransport, pNetworkContext, vectors, 3U );
+            }
+            else
+            {
+                memcpy( copyBuffer, fixedHeader, fixedHeaderLength );
+                memcpy( &copyBuffer[ fixedHeaderLength ], topic, topicLength );
+                memcpy( &copyBuffer[ fixedHeaderLength + topicLength ], payload, TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH );
+
+                retValue = prvTransportSendData( pTestTransport, pNetworkContext, copyBuffer, ( uint32_t ) frameLength );
+            }
+
+            *pSendTimeUs += TRANSPORT_TEST_GET_TIME_US() - startTimeUs;
+        }
+
+        if( retValue == true )
+        {
+            memset( pTransportTestBuffer, TRANSPORT_TEST_BUFFER_GUARD_PATTERN, batchFrames * frameLength );
+            retValue = prvBenchmarkRecvData( pNetworkContext, pTransportTestBuffer,
+                                             ( uint32_t ) ( batchFrames * frameLength ), NULL );
+        }
+
+        /* Verify every frame of the batch echoed back. */
+        for( frame = 0U; ( retValue == true ) && ( frame < batchFrames ); frame++ )
+        {
+            pFrame = &pTransportTestBuffer[ frame * frameLength ];
+
+            if( ( memcmp( pFrame, fixedHeader, fixedHeaderLength ) != 0 ) ||
+                ( memcmp( &pFrame[ fixedHeaderLength ], topic, topicLength ) != 0 ) ||
+                ( memcmp( &pFrame[ fixedHeaderLength + topicLength ], payload,
+                          TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH ) != 0 ) )
+            {
+                TEST_MESSAGE( "Echoed frame does not match the frame sent." );
+                retValue = false;
+            }
+        }
+
+        framesSent += batchFrames;
+    }
+
+    *pElapsedMs = FRTest_GetTimeMs() - startTimeMs;
+
+    return retValue;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compare writev with a copy into one buffer followed by send.
+ *
+ * The same MQTT PUBLISH like frames are echoed with both methods. The
+ * throughput and the time spent in the send path are reported for each
+ * method, to see whether a scatter-gather writev implementation pays off
+ * compared with the copy an MQTT library would otherwise do.
+ */
+TEST( Full_TransportInterfaceTest, Transport_WritevSendBenchmark )
+{
+    NetworkContext_t * pNetworkContext = threadParameter[ TRANSPORT_TEST_INDEX ].pNetworkContext;
+    uint8_t * pTransportTestBufferStart =
+        &( threadParameter[ TRANSPORT_TEST_INDEX ].transportTestBuffer[ TRANSPORT_TEST_BUFFER_PREFIX_GUARD_LENGTH ] );
+    uint32_t elapsedMs[ 2 ] = { 0U };
+    uint32_t sendTimeUs[ 2 ] = { 0U };
+    uint32_t method;
+    bool retValue;
+
+    for( method = 0U; method < 2U; method++ )
+    {
+        retValue = prvBenchmarkFramedSend( pNetworkContext, pTransportTestBufferStart, ( method == 0U ),
+                                           &elapsedMs[ method ], &sendTimeUs[ method ] );
+        TEST_ASSERT_MESSAGE( ( retValue == true ), "Framed echo failed." );
+    }
+
+    prvVerifyTestBufferGuard( threadParameter[ TRANSPORT_TEST_INDEX ].transportTestBuffer );
+
+    for( method = 0U; method < 2U; method++ )
+    {
+        prvPrintBenchmarkResult( "%s: %u frames of %u byte payload, %u ms, %lu bytes/s, %u us sending.",
+                                 ( method == 0U ) ? "Writev" : "Copy and send",
+                                 ( unsigned int ) TRANSPORT_TEST_WRITEV_BENCHMARK_FRAME_COUNT,
+                                 ( unsigned int ) TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH,
+                                 ( unsigned int ) elapsedMs[ method ],
+                                 ( unsigned long ) prvGetBenchmarkRate( ( uint64_t ) TRANSPORT_TEST_WRITEV_BENCHMARK_FRAME_COUNT *
+                                                                        TRANSPORT_TEST_WRITEV_BENCHMARK_PAYLOAD_LENGTH,
+                                                                        elapsedMs[ method ] ),
+                                 ( unsigned int ) sendTimeUs[ method ] );
+    }
+}
+
+#endif /* ifdef TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK */
+
 #endif
 /*-----------------------------------------------------------*/
 
@@ -1637,6 +2405,21 @@ TEST_GROUP_RUNNER( Full_TransportInterfaceTest )
     RUN_TEST_CASE( Full_TransportInterfaceTest, TransportRecv_NoDataToReceive );
     RUN_TEST_CASE( Full_TransportInterfaceTest, TransportRecv_ReturnZeroRetry );
 
+#ifdef TRANSPORT_TEST_EXECUTE_SESSION_RESUMPTION_TESTS
+    /* Reconnection benchmark. */
+    RUN_TEST_CASE( Full_TransportInterfaceTest, Transport_ReconnectSessionResumption );
+#endif
+
+#ifdef TRANSPORT_TEST_EXECUTE_CIPHER_SUITE_TESTS
+    /* Cipher suite benchmark. */
+    RUN_TEST_CASE( Full_TransportInterfaceTest, Transport_CipherSuiteBenchmark );
+#endif
+
+#ifdef TRANSPORT_TEST_EXECUTE_FRAGMENTED_RECV_TESTS
+    /* Receive reassembly benchmark. */
+    RUN_TEST_CASE( Full_TransportInterfaceTest, Transport_FragmentedRecv );
+#endif
+
 #ifdef TRANSPORT_TEST_EXECUTE_WRITEV_TESTS
     /* Invalid parameter test. Disable or replace assert may be required to run these tests. */
     RUN_TEST_CASE( Full_TransportInterfaceTest, TransportWritev_NetworkContextNullPtr );
@@ -1650,6 +2433,11 @@ TEST_GROUP_RUNNER( Full_TransportInterfaceTest )
     RUN_TEST_CASE( Full_TransportInterfaceTest, Transport_WritevRecvCompare );
     RUN_TEST_CASE( Full_TransportInterfaceTest, Transport_WritevRecvCompareMultithreaded );
 
+    #ifdef TRANSPORT_TEST_EXECUTE_WRITEV_BENCHMARK
+        /* Writev and send comparison benchmark. */
+        RUN_TEST_CASE( Full_TransportInterfaceTest, Transport_WritevSendBenchmark );
+    #endif
+
     /* Disconnect test. */
     RUN_TEST_CASE( Full_TransportInterfaceTest, TransportWritev_RemoteDisconnect );
 #endif
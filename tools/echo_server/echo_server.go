@@ -35,13 +35,18 @@
 	 "io"
 	 "io/ioutil"
 	 "log"
+	 mathrand "math/rand"
 	 "net"
+	 "net/http"
 	 "os"
+	 "sort"
+	 "strconv"
+	 "sync"
 	 "time"
 	 "bytes"
  )
 
- const readTimeoutSecond = 300
+ const defaultIdleTimeoutSecond = 300
  const disconnectCmd = "DISCONNECT"
 
  // Argument struct for JSON configuration
@@ -54,15 +59,347 @@
 	 ServerPort string `json:"server-port"`
 	 ServerCert string `json:"server-certificate-location"`
 	 ServerKey  string `json:"server-key-location"`
+
+	 // Session tickets are enabled when this option is omitted.
+	 SessionTickets    *bool `json:"session-tickets"`
+	 TicketKeyRotation int   `json:"session-ticket-key-rotation-seconds"`
+
+	 // Optional second certificate, e.g. an RSA certificate next to an EC one.
+	 SecondaryCert string `json:"secondary-certificate-location"`
+	 SecondaryKey  string `json:"secondary-key-location"`
+
+	 CipherSuites       []string `json:"cipher-suites"`
+	 CipherSuitePerPort bool     `json:"cipher-suite-per-port"`
+
+	 AcceptWorkers  int `json:"accept-workers"`
+	 MaxConnections int `json:"max-connections"`
+	 IdleTimeout    int `json:"idle-timeout-seconds"`
+
+	 StatsAddress  string `json:"stats-address"`
+	 StatsFile     string `json:"stats-file"`
+	 StatsInterval int    `json:"stats-interval-seconds"`
+
+	 FragmentMaxSize  int `json:"fragment-max-size"`
+	 FragmentMaxDelay int `json:"fragment-max-delay-ms"`
+ }
+
+ // Number of closed connections kept in the statistics.
+ const closedConnectionStatsCount = 64
+
+ // Upper bounds of the latency histogram buckets in microseconds. The last
+ // bucket counts the samples above the largest bound.
+ var latencyBucketBoundsUs = []int64{100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000}
+
+ type latencyHistogram struct {
+	 BucketBoundsUs []int64  `json:"bucket-bounds-us"`
+	 Counts         []uint64 `json:"counts"`
+	 Samples        uint64   `json:"samples"`
+	 SumUs          int64    `json:"sum-us"`
+	 MaxUs          int64    `json:"max-us"`
+ }
+
+ func newLatencyHistogram() latencyHistogram {
+	 return latencyHistogram{BucketBoundsUs: latencyBucketBoundsUs, Counts: make([]uint64, len(latencyBucketBoundsUs)+1)}
+ }
+
+ func (histogram *latencyHistogram) add(duration time.Duration) {
+	 durationUs := duration.Microseconds()
+	 bucket := sort.Search(len(histogram.BucketBoundsUs), func(index int) bool {
+		 return durationUs <= histogram.BucketBoundsUs[index]
+	 })
+
+	 histogram.Counts[bucket]++
+	 histogram.Samples++
+	 histogram.SumUs += durationUs
+	 if durationUs > histogram.MaxUs {
+		 histogram.MaxUs = durationUs
+	 }
+ }
+
+ type connectionStats struct {
+	 ID             uint64           `json:"id"`
+	 LocalAddress   string           `json:"local-address"`
+	 RemoteAddress  string           `json:"remote-address"`
+	 OpenedAt       time.Time        `json:"opened-at"`
+	 ClosedAt       *time.Time       `json:"closed-at,omitempty"`
+	 BytesIn        uint64           `json:"bytes-in"`
+	 BytesOut       uint64           `json:"bytes-out"`
+	 HandshakeUs    int64            `json:"handshake-us,omitempty"`
+	 SessionResumed bool             `json:"session-resumed,omitempty"`
+	 CipherSuite    string           `json:"cipher-suite,omitempty"`
+	 Error          string           `json:"error,omitempty"`
+	 EchoLatency    latencyHistogram `json:"echo-latency"`
+ }
+
+ // serverStats aggregates the statistics of all the TCP connections. The
+ // active connections and the most recently closed ones are also reported
+ // individually.
+ type serverStats struct {
+	 mutex             sync.Mutex
+	 nextID            uint64
+	 StartedAt         time.Time          `json:"started-at"`
+	 ActiveConnections int                `json:"active-connections"`
+	 TotalConnections  uint64             `json:"total-connections"`
+	 BytesIn           uint64             `json:"bytes-in"`
+	 BytesOut          uint64             `json:"bytes-out"`
+	 Errors            map[string]uint64  `json:"errors"`
+	 EchoLatency       latencyHistogram   `json:"echo-latency"`
+	 HandshakeDuration latencyHistogram   `json:"handshake-duration"`
+	 Connections       []*connectionStats `json:"connections"`
+ }
+
+ var echoStats = newServerStats()
+
+ func newServerStats() *serverStats {
+	 return &serverStats{StartedAt: time.Now(),
+		 Errors:            make(map[string]uint64),
+		 EchoLatency:       newLatencyHistogram(),
+		 HandshakeDuration: newLatencyHistogram(),
+	 }
+ }
+
+ // reset clears the statistics but keeps the active connections.
+ func (stats *serverStats) reset() {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.StartedAt = time.Now()
+	 stats.TotalConnections = 0
+	 stats.BytesIn = 0
+	 stats.BytesOut = 0
+	 stats.Errors = make(map[string]uint64)
+	 stats.EchoLatency = newLatencyHistogram()
+	 stats.HandshakeDuration = newLatencyHistogram()
+
+	 activeConnections := stats.Connections[:0]
+	 for _, connection := range stats.Connections {
+		 if connection.ClosedAt == nil {
+			 activeConnections = append(activeConnections, connection)
+		 }
+	 }
+	 stats.Connections = activeConnections
+ }
+
+ func (stats *serverStats) connectionOpened(connection net.Conn) *connectionStats {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.nextID++
+	 stats.ActiveConnections++
+	 stats.TotalConnections++
+
+	 connectionStats := &connectionStats{ID: stats.nextID,
+		 LocalAddress:  connection.LocalAddr().String(),
+		 RemoteAddress: connection.RemoteAddr().String(),
+		 OpenedAt:      time.Now(),
+		 EchoLatency:   newLatencyHistogram(),
+	 }
+	 stats.Connections = append(stats.Connections, connectionStats)
+
+	 return connectionStats
+ }
+
+ func (stats *serverStats) connectionClosed(connection *connectionStats) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 closedAt := time.Now()
+	 connection.ClosedAt = &closedAt
+	 stats.ActiveConnections--
+
+	 // Drop the oldest closed connections once there are too many of them.
+	 closedConnections := 0
+	 for index := len(stats.Connections) - 1; index >= 0; index-- {
+		 if stats.Connections[index].ClosedAt == nil {
+			 continue
+		 }
+
+		 closedConnections++
+		 if closedConnections > closedConnectionStatsCount {
+			 stats.Connections = append(stats.Connections[:index], stats.Connections[index+1:]...)
+		 }
+	 }
+ }
+
+ func (stats *serverStats) recordHandshake(connection *connectionStats, duration time.Duration, state tls.ConnectionState) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 connection.HandshakeUs = duration.Microseconds()
+	 connection.SessionResumed = state.DidResume
+	 connection.CipherSuite = tls.CipherSuiteName(state.CipherSuite)
+	 stats.HandshakeDuration.add(duration)
+ }
+
+ func (stats *serverStats) recordRead(connection *connectionStats, readBytes int) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 connection.BytesIn += uint64(readBytes)
+	 stats.BytesIn += uint64(readBytes)
+ }
+
+ // recordEcho records the bytes written back and the time from the end of the
+ // read to the end of the write.
+ func (stats *serverStats) recordEcho(connection *connectionStats, writeBytes int, latency time.Duration) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 connection.BytesOut += uint64(writeBytes)
+	 connection.EchoLatency.add(latency)
+	 stats.BytesOut += uint64(writeBytes)
+	 stats.EchoLatency.add(latency)
+ }
+
+ func (stats *serverStats) recordError(connection *connectionStats, kind string, err error) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 connection.Error = kind + ": " + err.Error()
+	 stats.Errors[kind]++
+ }
+
+ func (stats *serverStats) json() []byte {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 statsJSON, err := json.MarshalIndent(stats, "", "    ")
+	 if err != nil {
+		 log.Printf("Error %s while encoding statistics.", err)
+	 }
+
+	 return statsJSON
+ }
+
+ // serveStats serves the statistics as JSON over HTTP. A request to
+ // /stats/reset clears them, e.g. before a benchmark run.
+ func serveStats(address string) {
+	 http.HandleFunc("/stats", func(writer http.ResponseWriter, request *http.Request) {
+		 writer.Header().Set("Content-Type", "application/json")
+		 writer.Write(echoStats.json())
+	 })
+	 http.HandleFunc("/stats/reset", func(writer http.ResponseWriter, request *http.Request) {
+		 echoStats.reset()
+		 writer.WriteHeader(http.StatusNoContent)
+	 })
+
+	 log.Printf("Serving statistics on http://%s/stats", address)
+	 log.Fatal(http.ListenAndServe(address, nil))
+ }
+
+ // dumpStats periodically overwrites the file with the statistics.
+ func dumpStats(path string, interval time.Duration) {
+	 for {
+		 time.Sleep(interval)
+		 if err := ioutil.WriteFile(path, echoStats.json(), 0644); err != nil {
+			 log.Printf("Error %s while writing statistics to %s.", err, path)
+		 }
+	 }
+ }
+
+ // writeFragmented writes the data in randomly sized pieces of at most maxSize
+ // bytes. A random delay of at most maxDelay is inserted between the pieces.
+ // Each piece is sent in its own TCP segment, or TLS record for a secure
+ // connection, as the connections have Nagle's algorithm disabled.
+ func writeFragmented(connection net.Conn, data []byte, maxSize int, maxDelay time.Duration) (int, error) {
+	 written := 0
+	 for written < len(data) {
+		 if written > 0 && maxDelay > 0 {
+			 time.Sleep(time.Duration(mathrand.Int63n(int64(maxDelay) + 1)))
+		 }
+
+		 size := 1 + mathrand.Intn(maxSize)
+		 if size > len(data)-written {
+			 size = len(data) - written
+		 }
+
+		 writeBytes, err := connection.Write(data[written : written+size])
+		 written += writeBytes
+		 if err != nil {
+			 return written, err
+		 }
+	 }
+
+	 return written, nil
+ }
+
+ // idleTimeout returns how long a connection may stay without receiving data
+ // before it is closed.
+ func idleTimeout(config Argument) time.Duration {
+	 if config.IdleTimeout > 0 {
+		 return time.Duration(config.IdleTimeout) * time.Second
+	 }
+
+	 return defaultIdleTimeoutSecond * time.Second
+ }
+
+ // Cipher suites supported by AWS IoT Core. Note this is the intersection of the set
+ // of cipher suites supported by GO and by AWS IoT Core.
+ // See the complete list of supported cipher suites at https://docs.aws.amazon.com/iot/latest/developerguide/transport-security.html.
+ var defaultCipherSuites = []uint16{
+	 tls.TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+	 tls.TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+	 tls.TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+	 tls.TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+	 tls.TLS_AES_128_GCM_SHA256,
+	 tls.TLS_AES_256_GCM_SHA384,
  }
 
- func secureEcho(certPath string, keyPath string, port string, certVerify bool, verbose bool) {
+ // parseCipherSuites converts the cipher suite names of the configuration to
+ // their IDs. The default cipher suites are returned if no name is configured.
+ func parseCipherSuites(names []string) []uint16 {
+	 if len(names) == 0 {
+		 return defaultCipherSuites
+	 }
+
+	 known := make(map[string]uint16)
+	 for _, suite := range append(tls.CipherSuites(), tls.InsecureCipherSuites()...) {
+		 known[suite.Name] = suite.ID
+	 }
+
+	 suites := make([]uint16, 0, len(names))
+	 for _, name := range names {
+		 id, ok := known[name]
+		 if !ok {
+			 log.Fatalf("Unknown cipher suite %s in configuration.", name)
+		 }
+		 suites = append(suites, id)
+	 }
+
+	 return suites
+ }
+
+ // isTLS13CipherSuite returns whether the cipher suite is only used by TLS 1.3.
+ func isTLS13CipherSuite(id uint16) bool {
+	 for _, suite := range tls.CipherSuites() {
+		 if suite.ID == id {
+			 return len(suite.SupportedVersions) == 1 && suite.SupportedVersions[0] == tls.VersionTLS13
+		 }
+	 }
+
+	 return false
+ }
+
+ func secureEcho(config Argument) {
+	 certPath := config.ServerCert
+	 keyPath := config.ServerKey
 
 	 // load certificates
 	 servertCert, err := tls.LoadX509KeyPair(certPath, keyPath)
 	 if err != nil {
 		 log.Fatalf("Error %s while loading server certificates", err)
 	 }
+	 certificates := []tls.Certificate{servertCert}
+
+	 // The TLS stack presents the first certificate that is compatible with
+	 // the negotiated cipher suite.
+	 if config.SecondaryCert != "" {
+		 secondaryCert, err := tls.LoadX509KeyPair(config.SecondaryCert, config.SecondaryKey)
+		 if err != nil {
+			 log.Fatalf("Error %s while loading secondary server certificates", err)
+		 }
+		 certificates = append(certificates, secondaryCert)
+	 }
 
 	 serverCA, err := ioutil.ReadFile(certPath)
 	 if err != nil {
@@ -73,36 +410,117 @@
 	 serverCAPool.AppendCertsFromPEM(serverCA)
 
 	 var clientAuth tls.ClientAuthType
-	 if certVerify {
+	 if config.CertVerify {
 		 clientAuth = tls.RequireAndVerifyClientCert
 	 } else {
 		 clientAuth = tls.RequireAnyClientCert
 	 }
 
 	 //Configure TLS
-	 tlsConfig := tls.Config{Certificates: []tls.Certificate{servertCert},
-		 MinVersion: tls.VersionTLS12,
-		 RootCAs:    serverCAPool,
-		 ClientAuth: clientAuth,
-		 ClientCAs:  serverCAPool,
-		 // Cipher suites supported by AWS IoT Core. Note this is the intersection of the set
-		 // of cipher suites supported by GO and by AWS IoT Core.
-		 // See the complete list of supported cipher suites at https://docs.aws.amazon.com/iot/latest/developerguide/transport-security.html.
-		 CipherSuites: []uint16{
-			 tls.TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
-			 tls.TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
-			 tls.TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
-			 tls.TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
-			 tls.TLS_AES_128_GCM_SHA256,
-			 tls.TLS_AES_256_GCM_SHA384,
-		 },
+	 tlsConfig := tls.Config{Certificates: certificates,
+		 MinVersion:   tls.VersionTLS12,
+		 RootCAs:      serverCAPool,
+		 ClientAuth:   clientAuth,
+		 ClientCAs:    serverCAPool,
+		 CipherSuites: parseCipherSuites(config.CipherSuites),
 	 }
 
 	 tlsConfig.Rand = rand.Reader
-	 echoServerThread(port, &tlsConfig, verbose)
+
+	 if !config.CipherSuitePerPort {
+		 secureEchoThread(config.ServerPort, &tlsConfig, config)
+		 return
+	 }
+
+	 // Expose one cipher suite per port, starting from the server port, so
+	 // that a client can measure every suite without being reconfigured.
+	 basePort, err := strconv.Atoi(config.ServerPort)
+	 if err != nil {
+		 log.Fatalf("Error %s while parsing server port", err)
+	 }
+
+	 for index, suite := range tlsConfig.CipherSuites {
+		 suiteConfig := tlsConfig.Clone()
+		 if isTLS13CipherSuite(suite) {
+			 // Go does not allow the TLS 1.3 cipher suites to be restricted,
+			 // the suite preferred by the client is negotiated.
+			 suiteConfig.MinVersion = tls.VersionTLS13
+			 suiteConfig.CipherSuites = nil
+		 } else {
+			 suiteConfig.MaxVersion = tls.VersionTLS12
+			 suiteConfig.CipherSuites = []uint16{suite}
+		 }
+
+		 port := strconv.Itoa(basePort + index)
+		 log.Printf("Port %s serves cipher suite %s.", port, tls.CipherSuiteName(suite))
+
+		 if index == len(tlsConfig.CipherSuites)-1 {
+			 secureEchoThread(port, suiteConfig, config)
+		 } else {
+			 go secureEchoThread(port, suiteConfig, config)
+		 }
+	 }
+ }
+
+ // secureEchoThread applies the session resumption configuration and serves
+ // the secure echo server on the port.
+ func secureEchoThread(port string, tlsConfig *tls.Config, config Argument) {
+	 // Session tickets let a returning client resume its previous session with
+	 // an abbreviated handshake instead of a full key exchange.
+	 if config.SessionTickets != nil && !*config.SessionTickets {
+		 tlsConfig.SessionTicketsDisabled = true
+		 log.Printf("TLS session resumption is disabled on port %s.", port)
+	 } else if config.TicketKeyRotation > 0 {
+		 go rotateSessionTicketKeys(tlsConfig, time.Duration(config.TicketKeyRotation)*time.Second)
+	 }
+
+	 echoServerThread(port, tlsConfig, config)
+ }
+
+ // rotateSessionTicketKeys replaces the session ticket key every interval. The
+ // previous key is kept for decryption only, so a ticket stays valid for at
+ // most two intervals.
+ func rotateSessionTicketKeys(tlsConfig *tls.Config, interval time.Duration) {
+	 var keys [][32]byte
+
+	 for {
+		 var key [32]byte
+		 if _, err := rand.Read(key[:]); err != nil {
+			 log.Fatalf("Error %s while generating session ticket key", err)
+		 }
+
+		 keys = append([][32]byte{key}, keys...)
+		 if len(keys) > 2 {
+			 keys = keys[:2]
+		 }
+		 tlsConfig.SetSessionTicketKeys(keys)
+		 log.Printf("Session ticket key rotated, next rotation in %s.", interval)
+
+		 time.Sleep(interval)
+	 }
  }
 
- func echoServerThread(port string, tlsConfig *tls.Config, verbose bool) {
+ // tlsHandshake runs the server side of the TLS handshake ahead of the first
+ // read so that its duration and resumption status can be logged.
+ func tlsHandshake(connection *tls.Conn, timeout time.Duration, stats *connectionStats) error {
+	 connection.SetDeadline(time.Now().Add(timeout))
+	 defer connection.SetDeadline(time.Time{})
+
+	 handshakeStart := time.Now()
+	 if err := connection.Handshake(); err != nil {
+		 return err
+	 }
+
+	 handshakeDuration := time.Since(handshakeStart)
+	 state := connection.ConnectionState()
+	 echoStats.recordHandshake(stats, handshakeDuration, state)
+	 log.Printf("TLS handshake completed in %s. Session resumed: %t. Cipher suite: %s.",
+		 handshakeDuration, state.DidResume, tls.CipherSuiteName(state.CipherSuite))
+
+	 return nil
+ }
+
+ func echoServerThread(port string, tlsConfig *tls.Config, config Argument) {
 	 // listen on all interfaces
 	 var echoServer net.Listener
 	 var err error
@@ -115,8 +533,54 @@
 		 defer echoServer.Close()
 	 }
 
+	 // Each connection holds a slot until it is closed. Once all the slots are
+	 // taken, the accept goroutines stop accepting and new clients wait in the
+	 // listen backlog of the kernel.
+	 var connectionSlots chan struct{}
+	 if config.MaxConnections > 0 {
+		 connectionSlots = make(chan struct{}, config.MaxConnections)
+	 }
+
+	 // Several goroutines accept from the same listener so that a burst of
+	 // connections is not serialized behind a single accept loop.
+	 for worker := 1; worker < config.AcceptWorkers; worker++ {
+		 go acceptConnections(echoServer, port, tlsConfig, config, connectionSlots)
+	 }
+	 acceptConnections(echoServer, port, tlsConfig, config, connectionSlots)
+ }
+
+ // acquireConnectionSlot blocks until a connection is allowed to be served.
+ func acquireConnectionSlot(connectionSlots chan struct{}, port string) {
+	 if connectionSlots == nil {
+		 return
+	 }
+
+	 select {
+	 case connectionSlots <- struct{}{}:
+	 default:
+		 log.Printf("Connection limit of %d reached on port %s, waiting for a connection to close.", cap(connectionSlots), port)
+		 connectionSlots <- struct{}{}
+	 }
+ }
+
+ // releaseConnectionSlot allows another connection to be served.
+ func releaseConnectionSlot(connectionSlots chan struct{}) {
+	 if connectionSlots != nil {
+		 <-connectionSlots
+	 }
+ }
+
+ // acceptConnections accepts connections from the listener and serves each of
+ // them in its own goroutine.
+ func acceptConnections(echoServer net.Listener, port string, tlsConfig *tls.Config, config Argument, connectionSlots chan struct{}) {
 	 for {
 		 connection, err := echoServer.Accept()
+		 if err != nil {
+			 log.Printf("Error %s while trying to connect.", err)
+			 continue
+		 }
+
+		 acquireConnectionSlot(connectionSlots, port)
 
 		 if tcpConn, ok := connection.(*net.TCPConn); ok {
 			 err := tcpConn.SetLinger(0)
@@ -135,11 +599,10 @@
 			 log.Println("Opening unsecure TCP server listening to port " + port)
 		 }
 
-		 if err != nil {
-			 log.Printf("Error %s while trying to connect.", err)
-		 } else {
-			 go readWrite(connection, verbose)
-		 }
+		 go func(connection net.Conn) {
+			 readWrite(connection, config)
+			 releaseConnectionSlot(connectionSlots)
+		 }(connection)
 	 }
  }
 
@@ -201,19 +664,41 @@
 	}
 }
 
- func readWrite(connection net.Conn, verbose bool) {
+ func readWrite(connection net.Conn, config Argument) {
 	 defer connection.Close()
+
+	 verbose := config.Verbose
+	 timeout := idleTimeout(config)
+
+	 stats := echoStats.connectionOpened(connection)
+	 defer echoStats.connectionClosed(stats)
+
+	 if tlsConn, ok := connection.(*tls.Conn); ok {
+		 if err := tlsHandshake(tlsConn, timeout, stats); err != nil {
+			 log.Printf("Error %s during TLS handshake.", err)
+			 echoStats.recordError(stats, "handshake", err)
+			 return
+		 }
+	 }
+
 	 buffer := make([]byte, 4096)
 	 firstMessage := true
 	 for {
-		 connection.SetReadDeadline(time.Now().Add(readTimeoutSecond * time.Second))
+		 // Idle connections are closed once the deadline expires.
+		 connection.SetReadDeadline(time.Now().Add(timeout))
 		 readBytes, err := connection.Read(buffer)
+		 readTime := time.Now()
 		 if err != nil {
-			 if err != io.EOF {
+			 if netErr, ok := err.(net.Error); ok && netErr.Timeout() {
+				 log.Printf("Closing connection idle for %s.", timeout)
+				 echoStats.recordError(stats, "idle-timeout", err)
+			 } else if err != io.EOF {
 				 log.Printf("Error %s while reading data. Expected an EOF to signal end of connection", err)
+				 echoStats.recordError(stats, "read", err)
 			 }
 			 break
 		 } else {
+			 echoStats.recordRead(stats, readBytes)
 			 log.Printf("Read %d bytes.", readBytes)
 			 if verbose {
 				 hexStr := hex.EncodeToString( buffer[:readBytes] )
@@ -225,11 +710,19 @@
 			 }
 			 firstMessage = false;
 		 }
-		 writeBytes, err := connection.Write(buffer[:readBytes])
+		 var writeBytes int
+		 if config.FragmentMaxSize > 0 {
+			 writeBytes, err = writeFragmented(connection, buffer[:readBytes], config.FragmentMaxSize,
+				 time.Duration(config.FragmentMaxDelay)*time.Millisecond)
+		 } else {
+			 writeBytes, err = connection.Write(buffer[:readBytes])
+		 }
 		 if err != nil {
 			 log.Printf("Failed to send data with error: %s ", err)
+			 echoStats.recordError(stats, "write", err)
 			 break
 		 }
+		 echoStats.recordEcho(stats, writeBytes, time.Since(readTime))
 
 		 if writeBytes != 0 {
 			 log.Printf("Successfully echoed back %d bytes.", writeBytes)
@@ -239,13 +732,23 @@
 
  func startup(config Argument) {
 	 log.Println("Starting Echo application...")
+	 if config.StatsAddress != "" {
+		 go serveStats(config.StatsAddress)
+	 }
+	 if config.StatsFile != "" {
+		 interval := time.Duration(config.StatsInterval) * time.Second
+		 if interval <= 0 {
+			 interval = 10 * time.Second
+		 }
+		 go dumpStats(config.StatsFile, interval)
+	 }
 	 if config.Secure {
-		 secureEcho(config.ServerCert, config.ServerKey, config.ServerPort, config.CertVerify, config.Verbose)
+		 secureEcho(config)
 	 }
 	 if config.UseUDP {
 		udpEchoServerThread(config.ServerPort, config.Verbose)
 	 }
-	 echoServerThread(config.ServerPort, nil, config.Verbose)
+	 echoServerThread(config.ServerPort, nil, config)
  }
 
  func logSetup() {
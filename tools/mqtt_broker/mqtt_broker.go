@@ -0,0 +1,1236 @@
+/*
+ * FreeRTOS MQTT Broker V1.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+ package main
+
+ import (
+	 "bufio"
+	 "crypto/tls"
+	 "crypto/x509"
+	 "encoding/binary"
+	 "encoding/json"
+	 "errors"
+	 "flag"
+	 "fmt"
+	 "io"
+	 "io/ioutil"
+	 "log"
+	 "net"
+	 "net/http"
+	 "os"
+	 "sort"
+	 "strings"
+	 "sync"
+	 "time"
+ )
+
+ const defaultServerPort = "1883"
+ const defaultMaxQueuedMessages = 1000
+ const connectTimeout = 10 * time.Second
+
+ // MQTT 3.1.1 control packet types.
+ const (
+	 packetConnect     = 1
+	 packetConnack     = 2
+	 packetPublish     = 3
+	 packetPuback      = 4
+	 packetPubrec      = 5
+	 packetPubrel      = 6
+	 packetPubcomp     = 7
+	 packetSubscribe   = 8
+	 packetSuback      = 9
+	 packetUnsubscribe = 10
+	 packetUnsuback    = 11
+	 packetPingreq     = 12
+	 packetPingresp    = 13
+	 packetDisconnect  = 14
+ )
+
+ var packetNames = []string{"RESERVED", "CONNECT", "CONNACK", "PUBLISH", "PUBACK", "PUBREC", "PUBREL",
+	 "PUBCOMP", "SUBSCRIBE", "SUBACK", "UNSUBSCRIBE", "UNSUBACK", "PINGREQ", "PINGRESP", "DISCONNECT", "RESERVED"}
+
+ // CONNACK return codes.
+ const (
+	 connackAccepted             = 0
+	 connackUnacceptableProtocol = 1
+	 connackIdentifierRejected   = 2
+ )
+
+ const subackFailure = 0x80
+
+ var errProtocolViolation = errors.New("protocol violation")
+
+ // Argument struct for JSON configuration
+ type Argument struct {
+	 Verbose           bool   `json:"verbose"`
+	 Logging           bool   `json:"logging"`
+	 Secure            bool   `json:"secure-connection"`
+	 CertVerify        bool   `json:"cert-verify"`
+	 ServerPort        string `json:"server-port"`
+	 ServerCert        string `json:"server-certificate-location"`
+	 ServerKey         string `json:"server-key-location"`
+	 MaxQueuedMessages int    `json:"max-queued-messages"`
+	 StatsAddress      string `json:"stats-address"`
+	 BurstTopic        string `json:"burst-topic"`
+ }
+
+ // message is an application message routed by the broker.
+ type message struct {
+	 topic      string
+	 payload    []byte
+	 qos        byte
+	 retain     bool
+	 receivedAt time.Time
+ }
+
+ // inflightMessage is an outgoing QoS 1 or QoS 2 publish that is not yet
+ // acknowledged by the client.
+ type inflightMessage struct {
+	 packetID uint16
+	 message  *message
+	 qos      byte
+	 released bool
+	 queuedAt time.Time
+ }
+
+ // queuedMessage is a QoS 1 or QoS 2 publish for an offline persistent session.
+ type queuedMessage struct {
+	 message *message
+	 qos     byte
+ }
+
+ type session struct {
+	 clientID      string
+	 cleanSession  bool
+	 subscriptions map[string]byte
+	 inflight      []*inflightMessage
+	 queued        []queuedMessage
+	 incomingQoS2  map[uint16]bool
+	 lastPacketID  uint16
+	 client        *client
+ }
+
+ // outgoingPacket is a serialized packet waiting for the writer of a client.
+ // count is the number of packets of packetType in data when a burst is
+ // written at once, or 0 for a single packet.
+ type outgoingPacket struct {
+	 packetType byte
+	 data       []byte
+	 count      int
+	 receivedAt time.Time
+ }
+
+ type client struct {
+	 connection net.Conn
+	 clientID   string
+	 session    *session
+	 keepAlive  time.Duration
+	 will       *message
+	 outgoing   []outgoingPacket
+	 wake       chan struct{}
+	 done       chan struct{}
+	 finished   chan struct{}
+ }
+
+ type broker struct {
+	 mutex    sync.Mutex
+	 config   Argument
+	 sessions map[string]*session
+	 retained map[string]*message
+	 nextID   uint64
+ }
+
+/*-----------------------------------------------------------*/
+
+ var latencyBucketBoundsUs = []int64{100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000}
+
+ type latencyHistogram struct {
+	 BucketBoundsUs []int64  `json:"bucket-bounds-us"`
+	 Counts         []uint64 `json:"counts"`
+	 Samples        uint64   `json:"samples"`
+	 SumUs          int64    `json:"sum-us"`
+	 MaxUs          int64    `json:"max-us"`
+ }
+
+ func newLatencyHistogram() latencyHistogram {
+	 return latencyHistogram{BucketBoundsUs: latencyBucketBoundsUs, Counts: make([]uint64, len(latencyBucketBoundsUs)+1)}
+ }
+
+ func (histogram *latencyHistogram) add(duration time.Duration) {
+	 durationUs := duration.Microseconds()
+	 bucket := sort.Search(len(histogram.BucketBoundsUs), func(index int) bool {
+		 return durationUs <= histogram.BucketBoundsUs[index]
+	 })
+
+	 histogram.Counts[bucket]++
+	 histogram.Samples++
+	 histogram.SumUs += durationUs
+	 if durationUs > histogram.MaxUs {
+		 histogram.MaxUs = durationUs
+	 }
+ }
+
+ // brokerStats holds the timing instrumentation of the broker.
+ // connect-duration is measured from accepting the TCP connection until the
+ // CONNACK is queued, delivery-latency from reading a PUBLISH until it is
+ // written to a subscriber and ack-latency from queueing an outgoing QoS 1 or
+ // QoS 2 PUBLISH until its PUBACK or PUBCOMP is read.
+ type brokerStats struct {
+	 mutex             sync.Mutex
+	 StartedAt         time.Time         `json:"started-at"`
+	 ActiveConnections int               `json:"active-connections"`
+	 TotalConnections  uint64            `json:"total-connections"`
+	 BytesIn           uint64            `json:"bytes-in"`
+	 BytesOut          uint64            `json:"bytes-out"`
+	 PacketsIn         map[string]uint64 `json:"packets-in"`
+	 PacketsOut        map[string]uint64 `json:"packets-out"`
+	 DroppedMessages   uint64            `json:"dropped-messages"`
+	 Errors            map[string]uint64 `json:"errors"`
+	 ConnectDuration   latencyHistogram  `json:"connect-duration"`
+	 DeliveryLatency   latencyHistogram  `json:"delivery-latency"`
+	 AckLatency        latencyHistogram  `json:"ack-latency"`
+ }
+
+ var mqttStats = newBrokerStats()
+
+ func newBrokerStats() *brokerStats {
+	 stats := &brokerStats{}
+	 stats.clear()
+	 return stats
+ }
+
+ func (stats *brokerStats) clear() {
+	 stats.StartedAt = time.Now()
+	 stats.TotalConnections = 0
+	 stats.BytesIn = 0
+	 stats.BytesOut = 0
+	 stats.PacketsIn = make(map[string]uint64)
+	 stats.PacketsOut = make(map[string]uint64)
+	 stats.DroppedMessages = 0
+	 stats.Errors = make(map[string]uint64)
+	 stats.ConnectDuration = newLatencyHistogram()
+	 stats.DeliveryLatency = newLatencyHistogram()
+	 stats.AckLatency = newLatencyHistogram()
+ }
+
+ // reset clears the statistics but keeps the count of active connections.
+ func (stats *brokerStats) reset() {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.clear()
+ }
+
+ func (stats *brokerStats) connectionOpened() {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.ActiveConnections++
+	 stats.TotalConnections++
+ }
+
+ func (stats *brokerStats) connectionClosed() {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.ActiveConnections--
+ }
+
+ func (stats *brokerStats) recordConnect(duration time.Duration) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.ConnectDuration.add(duration)
+ }
+
+ func (stats *brokerStats) recordPacketIn(packetType byte, size int) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.PacketsIn[packetNames[packetType]]++
+	 stats.BytesIn += uint64(size)
+ }
+
+ // recordPacketOut records a packet written to a client. receivedAt is the
+ // time the broker read the PUBLISH being forwarded, if any.
+ func (stats *brokerStats) recordPacketOut(packet outgoingPacket) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 if packet.count > 0 {
+		 stats.PacketsOut[packetNames[packet.packetType]] += uint64(packet.count)
+	 } else {
+		 stats.PacketsOut[packetNames[packet.packetType]]++
+	 }
+	 stats.BytesOut += uint64(len(packet.data))
+	 if !packet.receivedAt.IsZero() {
+		 stats.DeliveryLatency.add(time.Since(packet.receivedAt))
+	 }
+ }
+
+ func (stats *brokerStats) recordAck(queuedAt time.Time) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.AckLatency.add(time.Since(queuedAt))
+ }
+
+ func (stats *brokerStats) recordDropped() {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.DroppedMessages++
+ }
+
+ func (stats *brokerStats) recordError(kind string) {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 stats.Errors[kind]++
+ }
+
+ func (stats *brokerStats) json() []byte {
+	 stats.mutex.Lock()
+	 defer stats.mutex.Unlock()
+
+	 encoded, err := json.MarshalIndent(stats, "", "  ")
+	 if err != nil {
+		 log.Printf("Failed to encode statistics: %s", err)
+		 return []byte("{}")
+	 }
+
+	 return encoded
+ }
+
+ // serveStats reports the statistics as JSON on /stats. A request to
+ // /stats/reset clears them, so that a test run can be measured in isolation.
+ func serveStats(address string) {
+	 http.HandleFunc("/stats", func(writer http.ResponseWriter, request *http.Request) {
+		 writer.Header().Set("Content-Type", "application/json")
+		 writer.Write(mqttStats.json())
+	 })
+	 http.HandleFunc("/stats/reset", func(writer http.ResponseWriter, request *http.Request) {
+		 mqttStats.reset()
+		 writer.WriteHeader(http.StatusNoContent)
+	 })
+
+	 log.Printf("Serving statistics on %s.", address)
+	 log.Fatal(http.ListenAndServe(address, nil))
+ }
+
+/*-----------------------------------------------------------*/
+
+ // readPacket reads one MQTT control packet and returns its fixed header
+ // byte, its variable header and payload, and its size on the wire.
+ func readPacket(reader *bufio.Reader) (byte, []byte, int, error) {
+	 header, err := reader.ReadByte()
+	 if err != nil {
+		 return 0, nil, 0, err
+	 }
+
+	 remainingLength := 0
+	 multiplier := 1
+	 lengthBytes := 0
+	 for {
+		 encodedByte, err := reader.ReadByte()
+		 if err != nil {
+			 return 0, nil, 0, err
+		 }
+		 lengthBytes++
+		 remainingLength += int(encodedByte&0x7F) * multiplier
+		 if encodedByte&0x80 == 0 {
+			 break
+		 }
+		 if lengthBytes == 4 {
+			 return 0, nil, 0, errProtocolViolation
+		 }
+		 multiplier *= 128
+	 }
+
+	 body := make([]byte, remainingLength)
+	 if _, err = io.ReadFull(reader, body); err != nil {
+		 return 0, nil, 0, err
+	 }
+
+	 return header, body, 1 + lengthBytes + remainingLength, nil
+ }
+
+ func encodePacket(header byte, body []byte) []byte {
+	 encoded := make([]byte, 1, len(body)+5)
+	 encoded[0] = header
+	 length := len(body)
+	 for {
+		 encodedByte := byte(length % 128)
+		 length /= 128
+		 if length > 0 {
+			 encodedByte |= 0x80
+		 }
+		 encoded = append(encoded, encodedByte)
+		 if length == 0 {
+			 break
+		 }
+	 }
+
+	 return append(encoded, body...)
+ }
+
+ func encodeAck(packetType byte, packetID uint16) []byte {
+	 header := packetType << 4
+	 if packetType == packetPubrel {
+		 header |= 0x02
+	 }
+
+	 return encodePacket(header, []byte{byte(packetID >> 8), byte(packetID)})
+ }
+
+ func encodePublish(message *message, qos byte, packetID uint16, dup bool, retain bool) []byte {
+	 header := byte(packetPublish<<4) | qos<<1
+	 if dup {
+		 header |= 0x08
+	 }
+	 if retain {
+		 header |= 0x01
+	 }
+
+	 body := make([]byte, 0, len(message.topic)+len(message.payload)+4)
+	 body = appendString(body, message.topic)
+	 if qos > 0 {
+		 body = append(body, byte(packetID>>8), byte(packetID))
+	 }
+	 body = append(body, message.payload...)
+
+	 return encodePacket(header, body)
+ }
+
+ func appendString(buffer []byte, value string) []byte {
+	 buffer = append(buffer, byte(len(value)>>8), byte(len(value)))
+	 return append(buffer, value...)
+ }
+
+ // readString reads a length prefixed UTF-8 string at offset and returns it
+ // with the offset following it.
+ func readString(body []byte, offset int) (string, int, error) {
+	 if offset+2 > len(body) {
+		 return "", 0, errProtocolViolation
+	 }
+	 length := int(binary.BigEndian.Uint16(body[offset:]))
+	 offset += 2
+	 if offset+length > len(body) {
+		 return "", 0, errProtocolViolation
+	 }
+
+	 return string(body[offset : offset+length]), offset + length, nil
+ }
+
+ func readPacketID(body []byte) (uint16, error) {
+	 if len(body) < 2 {
+		 return 0, errProtocolViolation
+	 }
+
+	 return binary.BigEndian.Uint16(body), nil
+ }
+
+/*-----------------------------------------------------------*/
+
+ func validTopicName(topic string) bool {
+	 return len(topic) > 0 && !strings.ContainsAny(topic, "+#")
+ }
+
+ func validTopicFilter(filter string) bool {
+	 if len(filter) == 0 {
+		 return false
+	 }
+
+	 levels := strings.Split(filter, "/")
+	 for index, level := range levels {
+		 if strings.Contains(level, "#") && (level != "#" || index != len(levels)-1) {
+			 return false
+		 }
+		 if strings.Contains(level, "+") && level != "+" {
+			 return false
+		 }
+	 }
+
+	 return true
+ }
+
+ // topicMatches reports whether a topic name matches a topic filter. Topics
+ // starting with '$' are not matched by filters starting with a wildcard.
+ func topicMatches(filter string, topic string) bool {
+	 filterLevels := strings.Split(filter, "/")
+	 topicLevels := strings.Split(topic, "/")
+
+	 if topic[0] == '$' && (filterLevels[0] == "+" || filterLevels[0] == "#") {
+		 return false
+	 }
+
+	 for index, level := range filterLevels {
+		 if level == "#" {
+			 return true
+		 }
+		 if index >= len(topicLevels) {
+			 return false
+		 }
+		 if level != "+" && level != topicLevels[index] {
+			 return false
+		 }
+	 }
+
+	 return len(filterLevels) == len(topicLevels)
+ }
+
+ // matchingQoS returns the maximum QoS of the subscriptions of a session
+ // matching a topic. Overlapping subscriptions deliver a message only once.
+ func (session *session) matchingQoS(topic string) (byte, bool) {
+	 matched := false
+	 var maximumQoS byte
+	 for filter, qos := range session.subscriptions {
+		 if topicMatches(filter, topic) {
+			 matched = true
+			 if qos > maximumQoS {
+				 maximumQoS = qos
+			 }
+		 }
+	 }
+
+	 return maximumQoS, matched
+ }
+
+ func (session *session) nextPacketID() uint16 {
+	 for {
+		 session.lastPacketID++
+		 if session.lastPacketID == 0 {
+			 continue
+		 }
+
+		 inUse := false
+		 for _, inflight := range session.inflight {
+			 if inflight.packetID == session.lastPacketID {
+				 inUse = true
+				 break
+			 }
+		 }
+		 if !inUse {
+			 return session.lastPacketID
+		 }
+	 }
+ }
+
+/*-----------------------------------------------------------*/
+
+ // enqueue hands a packet to the writer of a client. The broker mutex must be
+ // held, so that packets are written in the order they were produced.
+ func (client *client) enqueue(packetType byte, data []byte, receivedAt time.Time) {
+	 client.enqueuePacket(outgoingPacket{packetType: packetType, data: data, receivedAt: receivedAt})
+ }
+
+ // enqueuePacket hands a serialized packet, or a burst of packets, to the
+ // writer of a client. The broker mutex must be held.
+ func (client *client) enqueuePacket(packet outgoingPacket) {
+	 client.outgoing = append(client.outgoing, packet)
+	 select {
+	 case client.wake <- struct{}{}:
+	 default:
+	 }
+ }
+
+ // deliver sends a message to a session with the given QoS. QoS 0 messages
+ // are dropped for offline sessions, QoS 1 and QoS 2 messages are queued.
+ // The broker mutex must be held.
+ func (broker *broker) deliver(session *session, message *message, qos byte, retain bool) {
+	 if session.client == nil {
+		 if qos == 0 {
+			 return
+		 }
+		 if len(session.queued) >= broker.config.MaxQueuedMessages {
+			 mqttStats.recordDropped()
+			 if broker.config.Verbose {
+				 log.Printf("Dropping message on %s for offline client %s: queue is full.", message.topic, session.clientID)
+			 }
+			 return
+		 }
+		 session.queued = append(session.queued, queuedMessage{message: message, qos: qos})
+		 return
+	 }
+
+	 var packetID uint16
+	 if qos > 0 {
+		 packetID = session.nextPacketID()
+		 session.inflight = append(session.inflight, &inflightMessage{packetID: packetID, message: message, qos: qos, queuedAt: time.Now()})
+	 }
+	 session.client.enqueue(packetPublish, encodePublish(message, qos, packetID, false, retain), message.receivedAt)
+ }
+
+ // publish routes a message to all matching sessions and updates the
+ // retained messages.
+ func (broker *broker) publish(message *message) {
+	 broker.mutex.Lock()
+	 defer broker.mutex.Unlock()
+
+	 if message.retain {
+		 if len(message.payload) == 0 {
+			 delete(broker.retained, message.topic)
+		 } else {
+			 broker.retained[message.topic] = message
+		 }
+	 }
+
+	 for _, session := range broker.sessions {
+		 subscriptionQoS, matched := session.matchingQoS(message.topic)
+		 if !matched {
+			 continue
+		 }
+
+		 qos := message.qos
+		 if subscriptionQoS < qos {
+			 qos = subscriptionQoS
+		 }
+		 broker.deliver(session, message, qos, false)
+	 }
+ }
+
+ // resume resends the unacknowledged messages of a persistent session and
+ // delivers the messages queued while the client was offline. The broker
+ // mutex must be held.
+ func (broker *broker) resume(session *session) {
+	 for _, inflight := range session.inflight {
+		 inflight.queuedAt = time.Now()
+		 if inflight.released {
+			 session.client.enqueue(packetPubrel, encodeAck(packetPubrel, inflight.packetID), time.Time{})
+		 } else {
+			 session.client.enqueue(packetPublish, encodePublish(inflight.message, inflight.qos, inflight.packetID, true, false), time.Time{})
+		 }
+	 }
+
+	 queued := session.queued
+	 session.queued = nil
+	 for _, queuedMessage := range queued {
+		 broker.deliver(session, queuedMessage.message, queuedMessage.qos, false)
+	 }
+ }
+
+/*-----------------------------------------------------------*/
+
+ func (broker *broker) handleConnect(client *client, body []byte) (byte, bool, error) {
+	 protocolName, offset, err := readString(body, 0)
+	 if err != nil {
+		 return 0, false, err
+	 }
+	 if offset+4 > len(body) {
+		 return 0, false, errProtocolViolation
+	 }
+	 protocolLevel := body[offset]
+	 flags := body[offset+1]
+	 keepAlive := binary.BigEndian.Uint16(body[offset+2:])
+	 offset += 4
+
+	 if protocolName != "MQTT" || protocolLevel != 4 {
+		 return connackUnacceptableProtocol, false, nil
+	 }
+	 if flags&0x01 != 0 {
+		 return 0, false, errProtocolViolation
+	 }
+	 cleanSession := flags&0x02 != 0
+
+	 clientID, offset, err := readString(body, offset)
+	 if err != nil {
+		 return 0, false, err
+	 }
+
+	 if flags&0x04 != 0 {
+		 willTopic, nextOffset, err := readString(body, offset)
+		 if err != nil {
+			 return 0, false, err
+		 }
+		 willPayload, nextOffset, err := readString(body, nextOffset)
+		 if err != nil {
+			 return 0, false, err
+		 }
+		 offset = nextOffset
+
+		 willQoS := (flags >> 3) & 0x03
+		 if willQoS > 2 || !validTopicName(willTopic) {
+			 return 0, false, errProtocolViolation
+		 }
+		 client.will = &message{topic: willTopic, payload: []byte(willPayload), qos: willQoS, retain: flags&0x20 != 0}
+	 }
+
+	 // User name and password are accepted but not checked.
+
+	 if len(clientID) == 0 {
+		 if !cleanSession {
+			 return connackIdentifierRejected, false, nil
+		 }
+		 broker.mutex.Lock()
+		 broker.nextID++
+		 clientID = fmt.Sprintf("auto-%d", broker.nextID)
+		 broker.mutex.Unlock()
+	 }
+	 client.clientID = clientID
+
+	 client.keepAlive = time.Duration(keepAlive) * time.Second
+
+	 broker.mutex.Lock()
+	 defer broker.mutex.Unlock()
+
+	 state, exists := broker.sessions[clientID]
+	 if exists && state.client != nil {
+		 // Take over the session; the reader of the previous connection
+		 // publishes its will once the connection is closed.
+		 log.Printf("Client %s reconnected, closing the previous connection.", clientID)
+		 state.client.connection.Close()
+		 state.client = nil
+	 }
+
+	 // The session of a previous clean session connection is never resumed.
+	 sessionPresent := exists && !cleanSession && !state.cleanSession
+	 if !sessionPresent {
+		 state = &session{clientID: clientID, subscriptions: make(map[string]byte), incomingQoS2: make(map[uint16]bool)}
+		 broker.sessions[clientID] = state
+	 }
+	 state.cleanSession = cleanSession
+	 state.client = client
+	 client.session = state
+
+	 if broker.config.Verbose {
+		 log.Printf("Client %s connected from %s (clean session: %t, keep alive: %ds, session present: %t).",
+			 clientID, client.connection.RemoteAddr(), cleanSession, keepAlive, sessionPresent)
+	 }
+
+	 connackBody := []byte{0, connackAccepted}
+	 if sessionPresent {
+		 connackBody[0] = 1
+	 }
+	 client.enqueue(packetConnack, encodePacket(packetConnack<<4, connackBody), time.Time{})
+
+	 if sessionPresent {
+		 broker.resume(state)
+	 }
+
+	 return connackAccepted, true, nil
+ }
+
+ func (broker *broker) handlePublish(client *client, header byte, body []byte) error {
+	 qos := (header >> 1) & 0x03
+	 if qos > 2 {
+		 return errProtocolViolation
+	 }
+
+	 topic, offset, err := readString(body, 0)
+	 if err != nil {
+		 return err
+	 }
+	 if !validTopicName(topic) {
+		 return errProtocolViolation
+	 }
+
+	 var packetID uint16
+	 if qos > 0 {
+		 if packetID, err = readPacketID(body[offset:]); err != nil {
+			 return err
+		 }
+		 offset += 2
+	 }
+
+	 message := &message{topic: topic, payload: body[offset:], qos: qos, retain: header&0x01 != 0, receivedAt: time.Now()}
+
+	 if broker.config.Verbose {
+		 log.Printf("Client %s published %d bytes on %s (QoS %d, packet ID %d).", client.clientID, len(message.payload), topic, qos, packetID)
+	 }
+
+	 if broker.config.BurstTopic != "" && topic == broker.config.BurstTopic {
+		 return broker.handleBurst(client, message)
+	 }
+
+	 switch qos {
+	 case 0:
+		 broker.publish(message)
+	 case 1:
+		 broker.publish(message)
+		 broker.mutex.Lock()
+		 client.enqueue(packetPuback, encodeAck(packetPuback, packetID), time.Time{})
+		 broker.mutex.Unlock()
+	 case 2:
+		 // A retransmitted QoS 2 publish is acknowledged but not routed again.
+		 broker.mutex.Lock()
+		 duplicate := client.session.incomingQoS2[packetID]
+		 client.session.incomingQoS2[packetID] = true
+		 broker.mutex.Unlock()
+
+		 if !duplicate {
+			 broker.publish(message)
+		 }
+
+		 broker.mutex.Lock()
+		 client.enqueue(packetPubrec, encodeAck(packetPubrec, packetID), time.Time{})
+		 broker.mutex.Unlock()
+	 }
+
+	 return nil
+ }
+
+ // handleBurst answers a QoS 0 publish on the burst topic with a burst of QoS 0
+ // publishes on the same topic, written to the client at once so that they
+ // arrive back to back. The payload of the request holds the number of
+ // publishes and their payload length, as 16 bit big endian values. The
+ // request is not routed to the subscribers.
+ func (broker *broker) handleBurst(client *client, request *message) error {
+	 if request.qos != 0 || len(request.payload) != 4 {
+		 return errProtocolViolation
+	 }
+
+	 count := int(binary.BigEndian.Uint16(request.payload[0:2]))
+	 payloadLength := int(binary.BigEndian.Uint16(request.payload[2:4]))
+	 if count == 0 {
+		 return errProtocolViolation
+	 }
+
+	 var burst []byte
+	 for index := 0; index < count; index++ {
+		 payload := make([]byte, payloadLength)
+		 for offset := range payload {
+			 payload[offset] = byte(index + offset)
+		 }
+		 burst = append(burst, encodePublish(&message{topic: request.topic, payload: payload}, 0, 0, false, false)...)
+	 }
+
+	 if broker.config.Verbose {
+		 log.Printf("Sending a burst of %d publishes of %d bytes to client %s.", count, payloadLength, client.clientID)
+	 }
+
+	 broker.mutex.Lock()
+	 client.enqueuePacket(outgoingPacket{packetType: packetPublish, data: burst, count: count})
+	 broker.mutex.Unlock()
+
+	 return nil
+ }
+
+ // handleAck processes PUBACK, PUBREC, PUBREL and PUBCOMP packets.
+ func (broker *broker) handleAck(client *client, packetType byte, body []byte) error {
+	 packetID, err := readPacketID(body)
+	 if err != nil {
+		 return err
+	 }
+
+	 broker.mutex.Lock()
+	 defer broker.mutex.Unlock()
+
+	 session := client.session
+
+	 if packetType == packetPubrel {
+		 delete(session.incomingQoS2, packetID)
+		 client.enqueue(packetPubcomp, encodeAck(packetPubcomp, packetID), time.Time{})
+		 return nil
+	 }
+
+	 for index, inflight := range session.inflight {
+		 if inflight.packetID != packetID {
+			 continue
+		 }
+
+		 switch {
+		 case packetType == packetPuback && inflight.qos == 1,
+			 packetType == packetPubcomp && inflight.qos == 2 && inflight.released:
+			 session.inflight = append(session.inflight[:index], session.inflight[index+1:]...)
+			 mqttStats.recordAck(inflight.queuedAt)
+		 case packetType == packetPubrec && inflight.qos == 2:
+			 inflight.released = true
+			 client.enqueue(packetPubrel, encodeAck(packetPubrel, packetID), time.Time{})
+		 default:
+			 log.Printf("Client %s sent an unexpected %s for packet ID %d.", client.clientID, packetNames[packetType], packetID)
+		 }
+		 return nil
+	 }
+
+	 if broker.config.Verbose {
+		 log.Printf("Client %s sent %s for unknown packet ID %d.", client.clientID, packetNames[packetType], packetID)
+	 }
+
+	 return nil
+ }
+
+ func (broker *broker) handleSubscribe(client *client, body []byte) error {
+	 packetID, err := readPacketID(body)
+	 if err != nil {
+		 return err
+	 }
+
+	 var filters []string
+	 var grantedQoS []byte
+	 for offset := 2; offset < len(body); {
+		 filter, nextOffset, err := readString(body, offset)
+		 if err != nil || nextOffset >= len(body) {
+			 return errProtocolViolation
+		 }
+		 requestedQoS := body[nextOffset]
+		 offset = nextOffset + 1
+
+		 granted := requestedQoS
+		 if !validTopicFilter(filter) || requestedQoS > 2 {
+			 granted = subackFailure
+		 }
+		 filters = append(filters, filter)
+		 grantedQoS = append(grantedQoS, granted)
+
+		 if broker.config.Verbose {
+			 log.Printf("Client %s subscribed to %s (QoS %d).", client.clientID, filter, granted)
+		 }
+	 }
+	 if len(filters) == 0 {
+		 return errProtocolViolation
+	 }
+
+	 broker.mutex.Lock()
+	 defer broker.mutex.Unlock()
+
+	 session := client.session
+	 for index, filter := range filters {
+		 if grantedQoS[index] != subackFailure {
+			 session.subscriptions[filter] = grantedQoS[index]
+		 }
+	 }
+
+	 subackBody := append([]byte{byte(packetID >> 8), byte(packetID)}, grantedQoS...)
+	 client.enqueue(packetSuback, encodePacket(packetSuback<<4, subackBody), time.Time{})
+
+	 // Retained messages are sent after the SUBACK, with the retain flag set.
+	 for index, filter := range filters {
+		 if grantedQoS[index] == subackFailure {
+			 continue
+		 }
+		 for topic, retained := range broker.retained {
+			 if !topicMatches(filter, topic) {
+				 continue
+			 }
+			 qos := retained.qos
+			 if grantedQoS[index] < qos {
+				 qos = grantedQoS[index]
+			 }
+			 broker.deliver(session, retained, qos, true)
+		 }
+	 }
+
+	 return nil
+ }
+
+ func (broker *broker) handleUnsubscribe(client *client, body []byte) error {
+	 packetID, err := readPacketID(body)
+	 if err != nil {
+		 return err
+	 }
+
+	 broker.mutex.Lock()
+	 defer broker.mutex.Unlock()
+
+	 for offset := 2; offset < len(body); {
+		 filter, nextOffset, err := readString(body, offset)
+		 if err != nil {
+			 return err
+		 }
+		 offset = nextOffset
+
+		 delete(client.session.subscriptions, filter)
+		 if broker.config.Verbose {
+			 log.Printf("Client %s unsubscribed from %s.", client.clientID, filter)
+		 }
+	 }
+
+	 client.enqueue(packetUnsuback, encodeAck(packetUnsuback, packetID), time.Time{})
+
+	 return nil
+ }
+
+/*-----------------------------------------------------------*/
+
+ // writeLoop writes the packets queued for a client, so that the network is
+ // never written to while the broker mutex is held. The packets still queued
+ // when the client is done are flushed before the loop exits.
+ func (broker *broker) writeLoop(client *client) {
+	 defer close(client.finished)
+
+	 for done := false; !done; {
+		 select {
+		 case <-client.wake:
+		 case <-client.done:
+			 done = true
+		 }
+
+		 broker.mutex.Lock()
+		 pending := client.outgoing
+		 client.outgoing = nil
+		 broker.mutex.Unlock()
+
+		 for _, packet := range pending {
+			 if _, err := client.connection.Write(packet.data); err != nil {
+				 if !done {
+					 log.Printf("Failed to write to client %s: %s", client.clientID, err)
+					 mqttStats.recordError("write")
+				 }
+				 client.connection.Close()
+				 return
+			 }
+			 mqttStats.recordPacketOut(packet)
+		 }
+	 }
+ }
+
+ // stopWriter flushes the packets queued for a client and waits for its
+ // writer to exit.
+ func (broker *broker) stopWriter(client *client) {
+	 client.connection.SetWriteDeadline(time.Now().Add(time.Second))
+	 close(client.done)
+	 <-client.finished
+ }
+
+ func (broker *broker) serveClient(connection net.Conn) {
+	 acceptedAt := time.Now()
+	 mqttStats.connectionOpened()
+	 defer mqttStats.connectionClosed()
+	 defer connection.Close()
+
+	 if tlsConnection, ok := connection.(*tls.Conn); ok {
+		 tlsConnection.SetDeadline(time.Now().Add(connectTimeout))
+		 if err := tlsConnection.Handshake(); err != nil {
+			 log.Printf("TLS handshake with %s failed: %s", connection.RemoteAddr(), err)
+			 mqttStats.recordError("handshake")
+			 return
+		 }
+		 tlsConnection.SetDeadline(time.Time{})
+	 }
+
+	 client := &client{connection: connection, wake: make(chan struct{}, 1), done: make(chan struct{}), finished: make(chan struct{})}
+	 reader := bufio.NewReader(connection)
+
+	 connection.SetReadDeadline(time.Now().Add(connectTimeout))
+	 header, body, size, err := readPacket(reader)
+	 if err != nil || header>>4 != packetConnect {
+		 log.Printf("Closing connection from %s: no CONNECT received.", connection.RemoteAddr())
+		 mqttStats.recordError("connect")
+		 return
+	 }
+	 mqttStats.recordPacketIn(packetConnect, size)
+
+	 go broker.writeLoop(client)
+	 defer broker.stopWriter(client)
+
+	 returnCode, accepted, err := broker.handleConnect(client, body)
+	 if err != nil {
+		 log.Printf("Malformed CONNECT from %s.", connection.RemoteAddr())
+		 mqttStats.recordError("connect")
+		 return
+	 }
+	 if !accepted {
+		 log.Printf("Refusing connection from %s with return code %d.", connection.RemoteAddr(), returnCode)
+		 broker.mutex.Lock()
+		 client.enqueue(packetConnack, encodePacket(packetConnack<<4, []byte{0, returnCode}), time.Time{})
+		 broker.mutex.Unlock()
+		 return
+	 }
+	 mqttStats.recordConnect(time.Since(acceptedAt))
+
+	 // The keep alive is enforced by allowing one and a half times the keep
+	 // alive interval between two control packets.
+	 keepAlive := client.keepAlive
+
+	 disconnected := false
+	 for !disconnected {
+		 if keepAlive > 0 {
+			 connection.SetReadDeadline(time.Now().Add(keepAlive * 3 / 2))
+		 } else {
+			 connection.SetReadDeadline(time.Time{})
+		 }
+
+		 header, body, size, err = readPacket(reader)
+		 if err != nil {
+			 if netErr, ok := err.(net.Error); ok && netErr.Timeout() {
+				 log.Printf("Client %s exceeded its keep alive.", client.clientID)
+				 mqttStats.recordError("keep-alive")
+			 } else if err != io.EOF && broker.config.Verbose {
+				 log.Printf("Read from client %s failed: %s", client.clientID, err)
+			 }
+			 break
+		 }
+
+		 packetType := header >> 4
+		 mqttStats.recordPacketIn(packetType, size)
+
+		 switch packetType {
+		 case packetPublish:
+			 err = broker.handlePublish(client, header, body)
+		 case packetPuback, packetPubrec, packetPubcomp:
+			 err = broker.handleAck(client, packetType, body)
+		 case packetPubrel:
+			 if header&0x0F != 0x02 {
+				 err = errProtocolViolation
+			 } else {
+				 err = broker.handleAck(client, packetType, body)
+			 }
+		 case packetSubscribe:
+			 err = broker.handleSubscribe(client, body)
+		 case packetUnsubscribe:
+			 err = broker.handleUnsubscribe(client, body)
+		 case packetPingreq:
+			 broker.mutex.Lock()
+			 client.enqueue(packetPingresp, encodePacket(packetPingresp<<4, nil), time.Time{})
+			 broker.mutex.Unlock()
+		 case packetDisconnect:
+			 disconnected = true
+		 default:
+			 err = errProtocolViolation
+		 }
+
+		 if err != nil {
+			 log.Printf("Closing connection of client %s after a malformed %s.", client.clientID, packetNames[packetType])
+			 mqttStats.recordError("protocol")
+			 break
+		 }
+	 }
+
+	 broker.disconnect(client, disconnected)
+ }
+
+ // disconnect detaches a client from its session. The will is published
+ // unless the client sent a DISCONNECT.
+ func (broker *broker) disconnect(client *client, graceful bool) {
+	 broker.mutex.Lock()
+	 session := client.session
+	 if session.client == client {
+		 session.client = nil
+		 if session.cleanSession {
+			 delete(broker.sessions, session.clientID)
+		 }
+	 }
+	 will := client.will
+	 broker.mutex.Unlock()
+
+	 if broker.config.Verbose {
+		 log.Printf("Client %s disconnected (graceful: %t).", client.clientID, graceful)
+	 }
+
+	 if !graceful && will != nil {
+		 log.Printf("Publishing will of client %s on %s.", client.clientID, will.topic)
+		 will.receivedAt = time.Now()
+		 broker.publish(will)
+	 }
+ }
+
+/*-----------------------------------------------------------*/
+
+ func tlsConfiguration(config Argument) *tls.Config {
+	 serverCert, err := tls.LoadX509KeyPair(config.ServerCert, config.ServerKey)
+	 if err != nil {
+		 log.Fatalf("Failed to load server certificate: %s", err)
+	 }
+
+	 tlsConfig := &tls.Config{Certificates: []tls.Certificate{serverCert}}
+	 if config.CertVerify {
+		 certPool := x509.NewCertPool()
+		 caCert, err := ioutil.ReadFile(config.ServerCert)
+		 if err != nil {
+			 log.Fatalf("Failed to read server certificate: %s", err)
+		 }
+		 certPool.AppendCertsFromPEM(caCert)
+		 tlsConfig.ClientAuth = tls.RequireAndVerifyClientCert
+		 tlsConfig.ClientCAs = certPool
+	 } else {
+		 tlsConfig.ClientAuth = tls.RequestClientCert
+	 }
+
+	 return tlsConfig
+ }
+
+ func startup(config Argument) {
+	 if config.ServerPort == "" {
+		 config.ServerPort = defaultServerPort
+	 }
+	 if config.MaxQueuedMessages <= 0 {
+		 config.MaxQueuedMessages = defaultMaxQueuedMessages
+	 }
+
+	 if config.StatsAddress != "" {
+		 go serveStats(config.StatsAddress)
+	 }
+
+	 broker := &broker{config: config, sessions: make(map[string]*session), retained: make(map[string]*message)}
+
+	 var listener net.Listener
+	 var err error
+	 if config.Secure {
+		 listener, err = tls.Listen("tcp", ":"+config.ServerPort, tlsConfiguration(config))
+	 } else {
+		 listener, err = net.Listen("tcp", ":"+config.ServerPort)
+	 }
+	 if err != nil {
+		 log.Fatalf("Failed to listen on port %s: %s", config.ServerPort, err)
+	 }
+	 defer listener.Close()
+
+	 log.Printf("MQTT broker listening on port %s (TLS: %t).", config.ServerPort, config.Secure)
+
+	 for {
+		 connection, err := listener.Accept()
+		 if err != nil {
+			 log.Printf("Failed to accept connection: %s", err)
+			 continue
+		 }
+		 go broker.serveClient(connection)
+	 }
+ }
+
+ func logSetup() {
+	 brokerLogFile, e := os.OpenFile("mqtt_broker.log", os.O_CREATE|os.O_WRONLY|os.O_APPEND, 0666)
+	 if e != nil {
+		 log.Fatal("Failed to open log file.")
+	 } else {
+		 multi := io.MultiWriter(brokerLogFile, os.Stdout)
+		 log.SetOutput(multi)
+	 }
+ }
+
+ func main() {
+
+	 configLocation := flag.String("config", "./config.json", "Path to a JSON configuration.")
+	 flag.Parse()
+	 jsonFile, err := os.Open(*configLocation)
+
+	 if err != nil {
+		 log.Fatalf("Failed to open file with error: %s", err)
+	 }
+	 defer jsonFile.Close()
+
+	 byteValue, _ := ioutil.ReadAll(jsonFile)
+
+	 var config Argument
+	 err = json.Unmarshal(byteValue, &config)
+	 if err != nil {
+		 log.Fatalf("Failed to unmarshal json with error: %s", err)
+	 }
+
+	 if config.Logging {
+		 logSetup()
+	 }
+
+	 startup(config)
+ }
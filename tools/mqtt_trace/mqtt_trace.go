@@ -0,0 +1,340 @@
+/*
+ * FreeRTOS MQTT Trace Converter V1.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://aws.amazon.com/freertos
+ * http://www.FreeRTOS.org
+ */
+
+ package main
+
+ import (
+	 "bufio"
+	 "encoding/binary"
+	 "encoding/hex"
+	 "encoding/json"
+	 "flag"
+	 "fmt"
+	 "io"
+	 "log"
+	 "os"
+	 "regexp"
+	 "strconv"
+	 "strings"
+ )
+
+ // Size of a packet trace entry in the dump.
+ const entrySize = 12
+
+ // Flags of a packet trace entry. The bits above flagReceived hold the index
+ // of the connection.
+ const (
+	 flagReceived    = 0x01
+	 connectionShift = 1
+ )
+
+ // Addresses of the synthesized TCP connections in the pcap output.
+ const (
+	 clientPortBase = 49152
+	 brokerPort     = 1883
+ )
+
+ // Link type of raw IPv4 packets in the pcap output.
+ const linkTypeRaw = 101
+
+ var packetNames = []string{"RESERVED", "CONNECT", "CONNACK", "PUBLISH", "PUBACK", "PUBREC", "PUBREL",
+	 "PUBCOMP", "SUBSCRIBE", "SUBACK", "UNSUBSCRIBE", "UNSUBACK", "PINGREQ", "PINGRESP", "DISCONNECT", "RESERVED"}
+
+ var clientAddress = []byte{10, 0, 0, 1}
+ var brokerAddress = []byte{10, 0, 0, 2}
+
+ // Name of the test printed by Unity before a dump line.
+ var testNamePattern = regexp.MustCompile(`TEST\(([^)]*)\)`)
+
+ // Packet is a traced MQTT packet.
+ type Packet struct {
+	 TimeUs          uint64 `json:"time_us"`
+	 Direction       string `json:"direction"`
+	 Connection      int    `json:"connection"`
+	 Type            string `json:"type"`
+	 Flags           int    `json:"flags"`
+	 RemainingLength uint32 `json:"remaining_length"`
+	 Length          uint32 `json:"length"`
+	 PacketID        uint16 `json:"packet_id,omitempty"`
+	 header          byte
+	 timestamp       uint32
+ }
+
+ // Trace is the packet trace dumped after a test.
+ type Trace struct {
+	 Test        string   `json:"test,omitempty"`
+	 Overwritten int      `json:"overwritten"`
+	 Packets     []Packet `json:"packets"`
+ }
+
+ // Returns the encoded remaining length of a packet.
+ func encodeRemainingLength(length uint32) []byte {
+	 var encoded []byte
+
+	 for {
+		 b := byte(length & 0x7F)
+		 length >>= 7
+		 if length > 0 {
+			 b |= 0x80
+		 }
+		 encoded = append(encoded, b)
+		 if length == 0 {
+			 return encoded
+		 }
+	 }
+ }
+
+ // Decodes one dumped entry.
+ func decodeEntry(entry []byte) Packet {
+	 var packet Packet
+
+	 packet.timestamp = binary.BigEndian.Uint32(entry[0:4])
+	 packet.RemainingLength = binary.BigEndian.Uint32(entry[4:8])
+	 packet.PacketID = binary.BigEndian.Uint16(entry[8:10])
+	 packet.header = entry[10]
+	 packet.Type = packetNames[packet.header>>4]
+	 packet.Flags = int(packet.header & 0x0F)
+	 packet.Length = 1 + uint32(len(encodeRemainingLength(packet.RemainingLength))) + packet.RemainingLength
+	 packet.Direction = "sent"
+	 if entry[11]&flagReceived != 0 {
+		 packet.Direction = "received"
+	 }
+	 packet.Connection = 1 + int(entry[11]>>connectionShift)
+
+	 return packet
+ }
+
+ // Reads the packet traces dumped in a test log.
+ func readTraces(input io.Reader) ([]Trace, error) {
+	 var traces []Trace
+	 var current *Trace
+	 var lastTimestamp uint32
+	 var timeUs uint64
+	 started := false
+
+	 scanner := bufio.NewScanner(input)
+	 scanner.Buffer(make([]byte, 64*1024), 1024*1024)
+
+	 for scanner.Scan() {
+		 line := scanner.Text()
+
+		 if index := strings.Index(line, "MQTT_TRACE_BEGIN"); index >= 0 {
+			 fields := strings.Fields(line[index:])
+			 if len(fields) < 3 {
+				 return nil, fmt.Errorf("malformed trace header: %s", line)
+			 }
+			 overwritten, err := strconv.Atoi(fields[2])
+			 if err != nil {
+				 return nil, fmt.Errorf("malformed trace header: %s", line)
+			 }
+			 traces = append(traces, Trace{Overwritten: overwritten, Packets: []Packet{}})
+			 current = &traces[len(traces)-1]
+			 if match := testNamePattern.FindStringSubmatch(line[:index]); match != nil {
+				 current.Test = match[1]
+			 }
+		 } else if strings.Contains(line, "MQTT_TRACE_END") {
+			 current = nil
+		 } else if index := strings.Index(line, "MQTT_TRACE "); (index >= 0) && (current != nil) {
+			 fields := strings.Fields(line[index:])
+			 if len(fields) < 2 {
+				 continue
+			 }
+			 entries, err := hex.DecodeString(fields[1])
+			 if (err != nil) || (len(entries)%entrySize != 0) {
+				 return nil, fmt.Errorf("malformed trace line: %s", line)
+			 }
+			 for offset := 0; offset < len(entries); offset += entrySize {
+				 packet := decodeEntry(entries[offset : offset+entrySize])
+
+				 // The timestamps wrap around; they are made relative to the
+				 // first packet of the log.
+				 if !started {
+					 lastTimestamp = packet.timestamp
+					 started = true
+				 }
+				 timeUs += uint64(packet.timestamp - lastTimestamp)
+				 lastTimestamp = packet.timestamp
+				 packet.TimeUs = timeUs
+
+				 current.Packets = append(current.Packets, packet)
+			 }
+		 }
+	 }
+
+	 return traces, scanner.Err()
+ }
+
+ // Returns the checksum of an IPv4 header.
+ func ipChecksum(header []byte) uint16 {
+	 var sum uint32
+
+	 for i := 0; i < len(header); i += 2 {
+		 sum += uint32(binary.BigEndian.Uint16(header[i : i+2]))
+	 }
+	 for sum > 0xFFFF {
+		 sum = (sum & 0xFFFF) + (sum >> 16)
+	 }
+
+	 return ^uint16(sum)
+ }
+
+ // Writes the packet traces as raw IPv4 TCP packets in pcap format. Only the
+ // fixed header and, for acknowledgements and (UN)SUBSCRIBE packets, the packet
+ // identifier are captured; the original length covers the whole packet.
+ func writePcap(output io.Writer, traces []Trace) error {
+	 var fileHeader [24]byte
+
+	 binary.LittleEndian.PutUint32(fileHeader[0:4], 0xA1B2C3D4)
+	 binary.LittleEndian.PutUint16(fileHeader[4:6], 2)
+	 binary.LittleEndian.PutUint16(fileHeader[6:8], 4)
+	 binary.LittleEndian.PutUint32(fileHeader[16:20], 65535)
+	 binary.LittleEndian.PutUint32(fileHeader[20:24], linkTypeRaw)
+	 if _, err := output.Write(fileHeader[:]); err != nil {
+		 return err
+	 }
+
+	 nextClientPort := uint16(clientPortBase)
+	 for _, trace := range traces {
+		 // Client port, and next sequence number sent by the client and the
+		 // broker of each connection.
+		 clientPorts := make(map[int]uint16)
+		 clientSequence := make(map[int]uint32)
+		 brokerSequence := make(map[int]uint32)
+
+		 for _, packet := range trace.Packets {
+			 connection := packet.Connection
+			 clientPort, found := clientPorts[connection]
+			 if !found {
+				 clientPort = nextClientPort
+				 clientPorts[connection] = clientPort
+				 nextClientPort++
+			 }
+
+			 mqtt := []byte{packet.header}
+			 mqtt = append(mqtt, encodeRemainingLength(packet.RemainingLength)...)
+			 if (packet.header>>4 >= 4) && (packet.header>>4 <= 11) && (packet.RemainingLength >= 2) {
+				 mqtt = append(mqtt, byte(packet.PacketID>>8), byte(packet.PacketID))
+			 }
+
+			 var headers [40]byte
+			 totalLength := 40 + packet.Length
+			 if totalLength > 0xFFFF {
+				 totalLength = 0xFFFF
+			 }
+			 headers[0] = 0x45
+			 binary.BigEndian.PutUint16(headers[2:4], uint16(totalLength))
+			 binary.BigEndian.PutUint16(headers[6:8], 0x4000)
+			 headers[8] = 64
+			 headers[9] = 6
+
+			 tcp := headers[20:40]
+			 if packet.Direction == "sent" {
+				 copy(headers[12:16], clientAddress)
+				 copy(headers[16:20], brokerAddress)
+				 binary.BigEndian.PutUint16(tcp[0:2], clientPort)
+				 binary.BigEndian.PutUint16(tcp[2:4], brokerPort)
+				 binary.BigEndian.PutUint32(tcp[4:8], clientSequence[connection]+1)
+				 binary.BigEndian.PutUint32(tcp[8:12], brokerSequence[connection]+1)
+				 clientSequence[connection] += packet.Length
+			 } else {
+				 copy(headers[12:16], brokerAddress)
+				 copy(headers[16:20], clientAddress)
+				 binary.BigEndian.PutUint16(tcp[0:2], brokerPort)
+				 binary.BigEndian.PutUint16(tcp[2:4], clientPort)
+				 binary.BigEndian.PutUint32(tcp[4:8], brokerSequence[connection]+1)
+				 binary.BigEndian.PutUint32(tcp[8:12], clientSequence[connection]+1)
+				 brokerSequence[connection] += packet.Length
+			 }
+			 binary.BigEndian.PutUint16(headers[10:12], ipChecksum(headers[0:20]))
+			 tcp[12] = 5 << 4
+			 tcp[13] = 0x18
+			 binary.BigEndian.PutUint16(tcp[14:16], 0xFFFF)
+
+			 var recordHeader [16]byte
+			 binary.LittleEndian.PutUint32(recordHeader[0:4], uint32(packet.TimeUs/1000000))
+			 binary.LittleEndian.PutUint32(recordHeader[4:8], uint32(packet.TimeUs%1000000))
+			 binary.LittleEndian.PutUint32(recordHeader[8:12], uint32(len(headers)+len(mqtt)))
+			 binary.LittleEndian.PutUint32(recordHeader[12:16], 40+packet.Length)
+
+			 for _, data := range [][]byte{recordHeader[:], headers[:], mqtt} {
+				 if _, err := output.Write(data); err != nil {
+					 return err
+				 }
+			 }
+		 }
+	 }
+
+	 return nil
+ }
+
+ func main() {
+	 inputLocation := flag.String("input", "", "Path to the test log. Defaults to the standard input.")
+	 outputLocation := flag.String("output", "", "Path to the converted trace. Defaults to the standard output.")
+	 format := flag.String("format", "json", "Output format, \"json\" or \"pcap\".")
+	 flag.Parse()
+
+	 input := os.Stdin
+	 if *inputLocation != "" {
+		 file, err := os.Open(*inputLocation)
+		 if err != nil {
+			 log.Fatalf("Failed to open file with error: %s", err)
+		 }
+		 defer file.Close()
+		 input = file
+	 }
+
+	 traces, err := readTraces(input)
+	 if err != nil {
+		 log.Fatalf("Failed to read the packet traces with error: %s", err)
+	 }
+
+	 output := os.Stdout
+	 if *outputLocation != "" {
+		 file, err := os.Create(*outputLocation)
+		 if err != nil {
+			 log.Fatalf("Failed to create file with error: %s", err)
+		 }
+		 defer file.Close()
+		 output = file
+	 }
+
+	 writer := bufio.NewWriter(output)
+	 switch *format {
+	 case "json":
+		 encoder := json.NewEncoder(writer)
+		 encoder.SetIndent("", "    ")
+		 err = encoder.Encode(traces)
+	 case "pcap":
+		 err = writePcap(writer, traces)
+	 default:
+		 log.Fatalf("Unknown format: %s", *format)
+	 }
+	 if err == nil {
+		 err = writer.Flush()
+	 }
+	 if err != nil {
+		 log.Fatalf("Failed to write the packet traces with error: %s", err)
+	 }
+ }